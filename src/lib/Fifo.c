@@ -33,6 +33,8 @@
 static uint32_t FifoGetItemCount(uint32_t readCount, uint32_t writeCount);
 static uint32_t FifoGetFreeSpace(uint32_t totalCount, uint32_t readCount, uint32_t writeCount);
 static bool FifoConsumeItems(fifo_desc_t *pFifoDesc, uint32_t itemNb);
+static void FifoCopyItems(const fifo_desc_t *pFifoDesc, void *dest, uint32_t readIdx, uint32_t itemNb);
+static void FifoGetSpans(const fifo_desc_t *pFifoDesc, uint32_t idx, uint32_t itemNb, fifo_span_t *pSpans);
 
 // --- Private Variables ---
 // *** End Definitions ***
@@ -90,6 +92,59 @@ static bool FifoConsumeItems(fifo_desc_t *pFifoDesc, uint32_t itemNb) {
     return false;
 }
 
+/**
+ * \fn static void FifoCopyItems(const fifo_desc_t *pFifoDesc, void *dest, uint32_t readIdx, uint32_t itemNb)
+ * \brief Copy items from a fifo memory starting at a given idx (no checks)
+ *
+ * \param pFifoDesc: fifo descriptor
+ * \param dest: pointer to the data storage
+ * \param readIdx: idx of the first item to copy
+ * \param itemNb: number of items to copy
+ * \return void
+ */
+static void FifoCopyItems(const fifo_desc_t *pFifoDesc, void *dest, uint32_t readIdx, uint32_t itemNb) {
+    uint32_t buffOffset = 0;
+    // Check for roll-over
+    if ((readIdx + itemNb) >= pFifoDesc->ItemNb) {
+        // Pre roll-over read data
+        uint32_t ro_itemNb = pFifoDesc->ItemNb - readIdx;
+        buffOffset = ro_itemNb * pFifoDesc->ItemSize;
+        memcpy(&((uint8_t *)dest)[0], &pFifoDesc->pBuffer[readIdx * pFifoDesc->ItemSize], buffOffset);
+        // Take roll-over into account
+        readIdx = 0;
+        itemNb -= ro_itemNb;
+    }
+    // Regular data read
+    memcpy(&((uint8_t *)dest)[buffOffset], &pFifoDesc->pBuffer[readIdx * pFifoDesc->ItemSize], itemNb * pFifoDesc->ItemSize);
+}
+
+/**
+ * \fn static void FifoGetSpans(const fifo_desc_t *pFifoDesc, uint32_t idx, uint32_t itemNb, fifo_span_t *pSpans)
+ * \brief Split a fifo memory area starting at a given idx in contiguous spans (no checks)
+ *
+ * \param pFifoDesc: fifo descriptor
+ * \param idx: idx of the first item
+ * \param itemNb: number of items
+ * \param pSpans: pointer to an array of 2 spans to fill
+ * \return void
+ */
+static void FifoGetSpans(const fifo_desc_t *pFifoDesc, uint32_t idx, uint32_t itemNb, fifo_span_t *pSpans) {
+    // Take offset roll-over into account
+    if (idx >= pFifoDesc->ItemNb) {
+        idx -= pFifoDesc->ItemNb;
+    }
+    pSpans[0].pData = &pFifoDesc->pBuffer[idx * pFifoDesc->ItemSize];
+    pSpans[1].pData = pFifoDesc->pBuffer;
+    // Check for roll-over
+    if ((idx + itemNb) > pFifoDesc->ItemNb) {
+        pSpans[0].ItemNb = pFifoDesc->ItemNb - idx;
+        pSpans[1].ItemNb = itemNb - pSpans[0].ItemNb;
+    } else {
+        pSpans[0].ItemNb = itemNb;
+        pSpans[1].ItemNb = 0;
+    }
+}
+
 // *** Public Functions ***
 
 fifo_desc_t *FifoCreate(uint32_t itemNb, uint32_t itemSize) {
@@ -159,21 +214,7 @@ bool FifoWrite(fifo_desc_t *pFifoDesc, const void *src, uint32_t itemNb) {
 bool FifoRead(fifo_desc_t *pFifoDesc, void *dest, uint32_t itemNb, bool consume) {
     // Check if pFifoDesc, dest valid and if enough data to read
     if ((pFifoDesc != NULL) && (dest != NULL) && (FifoGetItemCount(pFifoDesc->ReadCount, pFifoDesc->WriteCount) >= itemNb)) {
-        uint32_t buffOffset = 0;
-        uint32_t tmpReadIdx = pFifoDesc->ReadIdx;
-        uint32_t tmpItemNb = itemNb;
-        // Check for roll-over
-        if ((tmpReadIdx + tmpItemNb) >= pFifoDesc->ItemNb) {
-            // Pre roll-over read data
-            uint32_t ro_itemNb = pFifoDesc->ItemNb - tmpReadIdx;
-            buffOffset = ro_itemNb * pFifoDesc->ItemSize;
-            memcpy(&((uint8_t *)dest)[0], &pFifoDesc->pBuffer[tmpReadIdx * pFifoDesc->ItemSize], buffOffset);
-            // Take roll-over into account
-            tmpReadIdx = 0;
-            tmpItemNb -= ro_itemNb;
-        }
-        // Regular data read
-        memcpy(&((uint8_t *)dest)[buffOffset], &pFifoDesc->pBuffer[tmpReadIdx * pFifoDesc->ItemSize], tmpItemNb * pFifoDesc->ItemSize);
+        FifoCopyItems(pFifoDesc, dest, pFifoDesc->ReadIdx, itemNb);
         // Check if data is consumed
         if (consume) {
             FifoConsumeItems(pFifoDesc, itemNb);
@@ -183,6 +224,52 @@ bool FifoRead(fifo_desc_t *pFifoDesc, void *dest, uint32_t itemNb, bool consume)
     return false;
 }
 
+bool FifoPeek(const fifo_desc_t *pFifoDesc, void *dest, uint32_t offset, uint32_t itemNb) {
+    // Check if pFifoDesc, dest valid and if enough data to read past the offset
+    if ((pFifoDesc != NULL) && (dest != NULL) && (FifoGetItemCount(pFifoDesc->ReadCount, pFifoDesc->WriteCount) >= offset + itemNb)) {
+        uint32_t readIdx = pFifoDesc->ReadIdx + offset;
+        // Take roll-over into account
+        if (readIdx >= pFifoDesc->ItemNb) {
+            readIdx -= pFifoDesc->ItemNb;
+        }
+        FifoCopyItems(pFifoDesc, dest, readIdx, itemNb);
+        return true;
+    }
+    return false;
+}
+
+bool FifoGetReadSpans(const fifo_desc_t *pFifoDesc, uint32_t offset, uint32_t itemNb, fifo_span_t *pSpans) {
+    // Check if pFifoDesc, pSpans valid and if enough data past the offset
+    if ((pFifoDesc != NULL) && (pSpans != NULL) && (FifoGetItemCount(pFifoDesc->ReadCount, pFifoDesc->WriteCount) >= offset + itemNb)) {
+        FifoGetSpans(pFifoDesc, pFifoDesc->ReadIdx + offset, itemNb, pSpans);
+        return true;
+    }
+    return false;
+}
+
+bool FifoGetWriteSpans(const fifo_desc_t *pFifoDesc, uint32_t itemNb, fifo_span_t *pSpans) {
+    // Check if pFifoDesc, pSpans valid and if enough space to write
+    if ((pFifoDesc != NULL) && (pSpans != NULL) && (FifoFreeSpace(pFifoDesc) >= itemNb)) {
+        FifoGetSpans(pFifoDesc, pFifoDesc->WriteIdx, itemNb, pSpans);
+        return true;
+    }
+    return false;
+}
+
+bool FifoCommit(fifo_desc_t *pFifoDesc, uint32_t itemNb) {
+    // Check if pFifoDesc valid and if enough space to add the items
+    if ((pFifoDesc != NULL) && (FifoFreeSpace(pFifoDesc) >= itemNb)) {
+        pFifoDesc->WriteCount += itemNb;
+        pFifoDesc->WriteIdx += itemNb;
+        // Take roll-over into account
+        if (pFifoDesc->WriteIdx >= pFifoDesc->ItemNb) {
+            pFifoDesc->WriteIdx -= pFifoDesc->ItemNb;
+        }
+        return true;
+    }
+    return false;
+}
+
 bool FifoConsume(fifo_desc_t *pFifoDesc, uint32_t itemNb) {
     //Check if pFifoDesc valid
     if (pFifoDesc != NULL) {
@@ -40,6 +40,11 @@ typedef struct _fifo_desc {
     uint32_t WriteIdx; // idx to the first free item space
 } fifo_desc_t;
 
+typedef struct _fifo_span {
+    uint8_t *pData; // pointer to the first item of the span
+    uint32_t ItemNb; // number of items in the span
+} fifo_span_t;
+
 // --- Public Constants ---
 // --- Public Variables ---
 // --- Public Function Prototypes ---
@@ -104,6 +109,51 @@ bool FifoWrite(fifo_desc_t *pFifoDesc, const void *src, uint32_t itemNb);
  */
 bool FifoRead(fifo_desc_t *pFifoDesc, void *dest, uint32_t itemNb, bool consume);
 
+/**
+ * \fn bool FifoPeek(const fifo_desc_t *pFifoDesc, void *dest, uint32_t offset, uint32_t itemNb)
+ * \brief Read items in a fifo starting at an offset from the first item, without consuming them
+ *
+ * \param pFifoDesc fifo descriptor
+ * \param dest pointer to the data storage
+ * \param offset number of items to skip
+ * \param itemNb number of items to read
+ * \return bool: true if the asked amount of items has been read, false otherwise (no read)
+ */
+bool FifoPeek(const fifo_desc_t *pFifoDesc, void *dest, uint32_t offset, uint32_t itemNb);
+
+/**
+ * \fn bool FifoGetReadSpans(const fifo_desc_t *pFifoDesc, uint32_t offset, uint32_t itemNb, fifo_span_t *pSpans)
+ * \brief Get the fifo memory holding items starting at an offset from the first item, without copying nor consuming them
+ *
+ * \param pFifoDesc fifo descriptor
+ * \param offset number of items to skip
+ * \param itemNb number of items to get
+ * \param pSpans pointer to an array of 2 spans to fill (the second one is empty unless the items roll-over)
+ * \return bool: true if the asked amount of items is available, false otherwise
+ */
+bool FifoGetReadSpans(const fifo_desc_t *pFifoDesc, uint32_t offset, uint32_t itemNb, fifo_span_t *pSpans);
+
+/**
+ * \fn bool FifoGetWriteSpans(const fifo_desc_t *pFifoDesc, uint32_t itemNb, fifo_span_t *pSpans)
+ * \brief Get the free fifo memory where the next items will be written, items are added with FifoCommit
+ *
+ * \param pFifoDesc fifo descriptor
+ * \param itemNb number of items to write
+ * \param pSpans pointer to an array of 2 spans to fill (the second one is empty unless the items roll-over)
+ * \return bool: true if there is enough free space, false otherwise
+ */
+bool FifoGetWriteSpans(const fifo_desc_t *pFifoDesc, uint32_t itemNb, fifo_span_t *pSpans);
+
+/**
+ * \fn bool FifoCommit(fifo_desc_t *pFifoDesc, uint32_t itemNb)
+ * \brief Add items written directly in the fifo write spans
+ *
+ * \param pFifoDesc fifo descriptor
+ * \param itemNb number of items to add
+ * \return bool: true if the items were added, false otherwise (none added)
+ */
+bool FifoCommit(fifo_desc_t *pFifoDesc, uint32_t itemNb);
+
 /**
  * \fn bool FifoConsume(fifo_desc_t *pFifoDesc, uint32_t itemNb)
  * \brief Consume data from a fifo
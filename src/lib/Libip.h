@@ -39,6 +39,7 @@
 #define ARP_REPLY 0x0002 // ARP Reply packet
 // IP protocols code
 #define IP_PROT_ICMP 1
+#define IP_PROT_IGMP 2
 #define IP_PROT_IPV4 4
 #define IP_PROT_TCP 6
 #define IP_PROT_UDP 17
@@ -76,6 +77,10 @@
 #define ICMP_PHOTURIS 0x28 // Photuris, Security failures
 #define ICMP_EXP_MOBIL 0x29 // ICMP for experimental mobility protocols such as Seamoby [RFC4065]
 // 0x2A through 0xFF Reserved
+// IGMP types
+#define IGMP_MEMBERSHIP_QUERY 0x11 // Membership Query (general or group-specific)
+#define IGMP_V2_MEMBERSHIP_REPORT 0x16 // Version 2 Membership Report
+#define IGMP_LEAVE_GROUP 0x17 // Leave Group
 
 // --- Public Types ---
 // Address Sizes
@@ -127,6 +132,14 @@ typedef struct _icmp_echo_header {
     uint16_t seq; // [2 bytes] Sequence number
 } icmp_header_t; // total: 8 bytes, 0 padding
 
+// IGMP header structure type
+typedef struct _igmp_header {
+    uint8_t type; // [1 byte] Type of message
+    uint8_t maxRespTime; // [1 byte] Max response time of a query (1/10 second)
+    uint16_t checksum; // [2 bytes] 1's complement checksum of struct
+    uint8_t groupAddr[IP_ADDR_LENGTH]; // [4 bytes] Group address (0 for a general query)
+} igmp_header_t; // total: 8 bytes, 0 padding
+
 // UDP header structure type
 typedef struct _udp_header {
     uint16_t srcPort; // [2 bytes] source port
@@ -140,6 +153,7 @@ typedef struct _udp_header {
 #define ARP_HEADER_SIZE (sizeof(arp_header_t)) // [28 bytes]
 #define IPV4_HEADER_SIZE (sizeof(ipv4_header_t)) // [20 bytes]
 #define ICMP_HEADER_SIZE (sizeof(icmp_header_t)) // [8 bytes]
+#define IGMP_HEADER_SIZE (sizeof(igmp_header_t)) // [8 bytes]
 #define UDP_HEADER_SIZE (sizeof(udp_header_t)) // [8 bytes]
 #define NETWORK_HEADER_SIZE (ETH_HEADER_SIZE + IPV4_HEADER_SIZE + UDP_HEADER_SIZE) // [42 bytes] network header size (UDP + IP + ETH)
 
@@ -147,6 +161,15 @@ typedef struct _udp_header {
 #define ETHERNET_PAYLOAD_SIZE  1500
 #define ETHERNET_MAX_DATA_SIZE (ETHERNET_PAYLOAD_SIZE - (IPV4_HEADER_SIZE + UDP_HEADER_SIZE)) // [1472 bytes] frame max data size (if more, frame is fragmented)
 #define ETHERNET_FRAME_LENTGH_MAX (ETHERNET_PAYLOAD_SIZE + ETH_HEADER_SIZE)
+#define ETHERNET_JUMBO_PAYLOAD_SIZE 9000 // Max payload of jumbo frames
+#define IPV4_MIN_MTU 576 // Min mtu every ipv4 host must support
+#define IPV4_FRAGMENT_DATA_SIZE (ETHERNET_PAYLOAD_SIZE - IPV4_HEADER_SIZE) // [1480 bytes] ip payload of a full size fragment
+#define UDP_MAX_DATA_SIZE (0xFFFF - (IPV4_HEADER_SIZE + UDP_HEADER_SIZE)) // [65507 bytes] max udp datagram data size
+
+// Ipv4 fragmentOffsetAndFlags field (host order)
+#define IPV4_FLAG_DF 0x4000 // Don't fragment
+#define IPV4_FLAG_MF 0x2000 // More fragments
+#define IPV4_FRAG_OFFSET_MASK 0x1FFF // Fragment offset (8 bytes unit)
 
 // --- Public Variables ---
 // --- Public Function Prototypes ---
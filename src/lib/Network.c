@@ -31,12 +31,19 @@
 // *** Definitions ***
 // --- Private Types ---
 typedef struct _network_msg {
+    const fifo_span_t *pDataSpans; // [4 bytes] Data sent straight from the port fifo (NULL: data is in the buffer)
     uint8_t DstIP[IP_ADDR_LENGTH]; // [4 bytes]
+    uint32_t DataSum; // [4 bytes] Udp data one's complement sum (valid if HasUdpChecksum)
     uint16_t SrcPort; // [2 bytes]
     uint16_t DstPort; // [2 bytes]
     uint16_t DataSize; // [2 bytes]
     uint16_t HeaderSize; // [2 bytes]
-} network_msg_info_t; // total: 12 bytes, 0 padding
+    uint16_t PayloadSize; // [2 bytes] Transport payload size (differs from DataSize in fragments)
+    uint16_t Identification; // [2 bytes]
+    uint16_t FragmentField; // [2 bytes] Ip flags and fragment offset (host order)
+    uint8_t Dscp; // [1 byte]
+    bool HasUdpChecksum; // [1 byte]
+} network_msg_info_t; // total: 28 bytes, 0 padding
 
 typedef struct _arp_status {
     uint8_t IsInitialised: 1; // [1 bit]
@@ -55,8 +62,22 @@ typedef struct _arp_entry {
 
 typedef struct _ip_msg_desc {
     uint16_t MsgSize; // [2 bytes]
+    uint16_t PortNb; // [2 bytes] Sender port (rx) or recipient port (tx, 0: port distant port)
     uint8_t IpAddr[IP_ADDR_LENGTH]; // [4 bytes]
-} network_msg_desc_t; // total: 8 bytes, 2 bytes of padding
+} network_msg_desc_t; // total: 8 bytes, 0 padding
+
+typedef struct _ip_reasm_ctx {
+    uint8_t *pData; // Reassembled packet (eth and ip headers followed by the ip payload)
+    uint8_t *pHoleMap; // One bit per received 8 bytes block of ip payload
+    uint32_t Timeout; // Time at which the datagram is evicted
+    uint32_t EndOffset; // End of the furthest fragment received
+    uint16_t Identification;
+    uint16_t TotalSize; // Ip payload size, known once the last fragment is received (0 otherwise)
+    uint16_t BlockNb; // Number of received blocks
+    uint8_t SrcIp[IP_ADDR_LENGTH];
+    uint8_t Protocol;
+    bool IsUsed;
+} ip_reasm_ctx_t;
 
 typedef struct _network_port_info {
     const network_port_desc_t *pDesc;
@@ -65,30 +86,85 @@ typedef struct _network_port_info {
     void* pFifoTxMsg;
     void* pFifoTxMsgDesc;
     uint32_t TimerRequestARP;
+    uint32_t TimerCoalesce; // Virtual com port: time at which gathered data must be sent
+    uint16_t TxMsgOffset; // Segmented or fragmented message: data already sent
+    uint16_t TxFragId; // Fragmented message: ip identification of the datagram in progress
     uint16_t InPortNb;
     uint16_t OutPortNb;
     uint8_t CounterARP;
     bool IsVirtualComRx;
     bool IsVirtualComTx;
     uint8_t DstIpAddr[IP_ADDR_LENGTH];
+    int32_t ShaperTokens; // Token bucket level (milli-bytes)
+    uint32_t ShaperTime; // Last token bucket refill time
+    uint32_t ShaperHoldTime; // Time the shaper started to hold back traffic
+    bool IsShaperHolding;
+    network_port_stats_t Stats;
+    bool IsConnected; // Only datagrams from DstIpAddr:OutPortNb are received
+    uint8_t NextConnPortId; // Next connected port of the same hash bucket
+    bool IsTxBatch; // Queued batch to drain in the next tx pass, whatever the priority class
 } network_port_info_t;
 
+typedef struct _ip_addr_info {
+    uint32_t IpAddrWord; // [4 bytes] Memory order words
+    uint32_t SubnetMaskWord; // [4 bytes]
+    uint32_t NetworkWord; // [4 bytes]
+    uint32_t BroadcastWord; // [4 bytes]
+    uint8_t IpAddr[IP_ADDR_LENGTH]; // [4 bytes]
+} ip_addr_info_t; // total: 20 bytes, 0 padding
+
+typedef struct _ip_route {
+    uint32_t NetworkWord; // [4 bytes] Memory order words
+    uint32_t MaskWord; // [4 bytes]
+    uint32_t GatewayWord; // [4 bytes]
+    uint8_t PrefixLength; // [1 byte]
+} ip_route_t; // total: 13 bytes, 3 bytes of padding
+
+typedef struct _route_cache_entry {
+    uint32_t DstWord; // [4 bytes] Memory order words
+    uint32_t NextHopWord; // [4 bytes]
+    bool IsValid; // [1 byte]
+} route_cache_entry_t; // total: 9 bytes, 3 bytes of padding
+
+typedef struct _mcast_group {
+    uint32_t GroupWord; // [4 bytes] Memory order word
+    uint8_t *pPortMap; // One bit per network port subscribed to the group
+    uint8_t PortCount; // [1 byte] Subscribed port nb (0: free entry)
+} mcast_group_t;
+
 typedef struct _network_ctrl_info {
     const network_ctrl_desc_t *pDesc;
     arp_entry_t *pArpArray;
     uint32_t TimerDecayARP;
     uint32_t IcmpReplyDelay; // Contains the delay between ICMP echo and its response (valid only when ICMPReplyReceived is true)
     bool IcmpReplyReceived; // Indicates if we received an answer to the last ICMP echo sent by this controller
+    ip_addr_info_t *pAddrArray; // Local addresses, primary one (IpAddr and SubnetMask) first then aliases
+    uint8_t AddrNb; // Used local address nb
     uint8_t IpAddr[IP_ADDR_LENGTH];
     uint8_t SubnetMask[IP_ADDR_LENGTH];
     uint8_t MacAddr[MAC_ADDR_LENGTH];
+    uint16_t IpIdentification; // Next identification of fragmented datagrams
+    uint16_t Mtu; // Max ip packet size
+    uint16_t MaxDataSize; // Max udp data size of an unfragmented datagram
+    uint16_t FragDataSize; // Ip payload size of a full size fragment (multiple of 8 bytes)
+    ip_reasm_ctx_t *pReasmArray; // Ip reassembly contexts
+    ip_route_t *pRouteArray; // Routes sorted by decreasing prefix length, default gateway last
+    route_cache_entry_t *pRouteCache; // Next hops of recent off-subnet recipients
+    uint8_t RouteCount; // Used route nb
+    mcast_group_t *pMcastArray; // Joined multicast groups, open addressing on the group address hash
+    uint64_t McastMacFilter; // One bit per hashed multicast mac address of the joined groups
 } network_ctrl_info_t;
 
 typedef struct _network_module_info {
     const network_init_desc_t *pInitDesc; // Module initialisation descriptor
     network_ctrl_info_t *pCtrlInfoList; // Network controller list
     network_port_info_t *pPortInfoList; // Network port list
+    uint8_t *pTxPortOrder; // Network port ids sorted by decreasing priority class
+    uint8_t *pConnTable; // First connected port id of each endpoints hash bucket
     uint8_t *pBuffer; // Tx/Rx buffer
+    uint16_t BufferSize; // Tx/Rx buffer size, fits the largest controller frame
+    uint16_t NextEphemeralPort; // Next ephemeral local port candidate
+    bool IsRxPass; // Rx pass in progress, the buffer holds the received frame
 } network_module_info_t;
 
 // --- Private Constants ---
@@ -97,13 +173,57 @@ typedef struct _network_module_info {
 #define NETWORK_ARP_REQUEST_COOLDOWN 2000 // Max time between two arp requests
 #define NETWORK_ARP_DECAY_COOLDOWN 1000 // Min time between two arp table decay refresh
 #define NETWORK_ARP_DECAY_TIME 60000 // Max time without activity before decaying an arp entry
+#define NETWORK_AGGREGATE_PREFIX_SIZE 2 // Length prefix of each message in an aggregated datagram (big endian)
+#define NETWORK_REASM_TIMEOUT 2000 // Max time to receive all the fragments of an ip datagram
+#define NETWORK_REASM_HEADER_SIZE (ETH_HEADER_SIZE + IPV4_HEADER_SIZE) // Headers stored ahead of a reassembled ip payload
+#define NETWORK_ROUTE_CACHE_SIZE 8 // Route cache entry nb (power of 2)
+#define NETWORK_CONN_TABLE_SIZE 16 // Connected port hash bucket nb (power of 2)
+#define NETWORK_PORT_NONE 0xFF // No port id
+#define NETWORK_MCAST_TTL 1 // Multicast datagrams stay on the local network (no multicast routing)
+#define NETWORK_REASM_MAP_SIZE(maxSize) ((((uint32_t)(maxSize) + UDP_HEADER_SIZE + 7) / 8 + 7) / 8) // Hole map size of a reassembly context (bytes)
+
+// Dscp value of each priority class
+static const uint8_t NetworkPrioDscp[NETWORK_PRIO_NB] = {
+    0, // NETWORK_PRIO_BEST_EFFORT: CS0
+    26, // NETWORK_PRIO_CRITICAL: AF31
+    46, // NETWORK_PRIO_REAL_TIME: EF
+    48, // NETWORK_PRIO_CONTROL: CS6
+};
+
+// Multicast groups joined by every host (queries) and every router (leave messages)
+static const uint8_t NetworkMcastAllHosts[IP_ADDR_LENGTH] = {224, 0, 0, 1};
+static const uint8_t NetworkMcastAllRouters[IP_ADDR_LENGTH] = {224, 0, 0, 2};
 
 // --- Private Function Prototypes ---
 // Useful functions
 static void NetworkInitMsgInfo(network_msg_info_t *pMsgInfo, const uint8_t *pIpAddr, uint16_t srcPort, uint16_t dstPort, uint16_t dataSize);
-static bool NetworkIsIpValid(const uint8_t *pIpAddr, const uint8_t *pRefIpAddr, const uint8_t *pSubnetMask);
-static bool NetworkIsIpBroadcast(const uint8_t *pIpAddr, const uint8_t *pRefIpAddr, const uint8_t *pSubnetMask);
+static uint32_t NetworkIpWord(const uint8_t *pIpAddr);
+static uint8_t NetworkIpHash(uint32_t ipWord);
+static uint16_t NetworkFlowHash(const uint8_t *pSrcIp, uint16_t srcPort, uint16_t dstPort);
+static void NetworkSetAddrInfo(ip_addr_info_t *pAddr, const uint8_t *pIpAddr, const uint8_t *pSubnetMask);
+static void NetworkUpdateCtrlAddr(network_ctrl_info_t *pNetworkCtrl);
+static const ip_addr_info_t *NetworkGetSubnetAddr(const uint8_t *pIpAddr, const network_ctrl_info_t *pNetworkCtrl);
+static const ip_addr_info_t *NetworkGetLocalAddr(const uint8_t *pIpAddr, const network_ctrl_info_t *pNetworkCtrl);
+static const uint8_t *NetworkGetSrcIp(network_ctrl_info_t *pNetworkCtrl, const uint8_t *pDstIp);
+static void NetworkFlushRouteCache(network_ctrl_info_t *pNetworkCtrl);
+static bool NetworkGetNextHop(network_ctrl_info_t *pNetworkCtrl, const uint8_t *pDstIp, uint8_t *pNextHop);
+static bool NetworkSetRoute(network_ctrl_info_t *pNetworkCtrl, uint32_t netWord, uint32_t maskWord, const uint8_t *pGateway);
+static bool NetworkDeleteRoute(network_ctrl_info_t *pNetworkCtrl, uint32_t netWord, uint32_t maskWord);
+static bool NetworkIsIpValid(const uint8_t *pIpAddr, const network_ctrl_info_t *pNetworkCtrl);
+static bool NetworkIsIpBroadcast(const uint8_t *pIpAddr, const network_ctrl_info_t *pNetworkCtrl);
+static bool NetworkIsIpMulticast(const uint8_t *pIpAddr);
+static uint8_t NetworkMcastMacHash(const uint8_t *pGroupAddr);
+static mcast_group_t *NetworkGetMcastGroup(const network_ctrl_info_t *pNetworkCtrl, uint32_t groupWord);
+static mcast_group_t *NetworkAddMcastGroup(network_ctrl_info_t *pNetworkCtrl, uint32_t groupWord);
+static void NetworkRemoveMcastGroup(network_ctrl_info_t *pNetworkCtrl, mcast_group_t *pGroup);
 static bool NetworkAcceptIncIpPacket(uint8_t ctrlId, ipv4_header_t *pIpHeader);
+static void NetworkSortTxPorts(void);
+static uint32_t NetworkPortTxPending(uint8_t portId);
+static bool NetworkShaperAllow(uint8_t portId, uint32_t frameSize);
+static void NetworkShaperRefund(uint8_t portId, uint32_t frameSize);
+static uint16_t NetworkPortMaxDataSize(uint8_t portId);
+static uint16_t NetworkPortMaxMsgSize(uint8_t portId);
+static void NetworkGetMsgDestIp(uint8_t portId, const network_msg_desc_t *pMsgDesc, uint8_t *pDestIp);
 // Arp functions
 static arp_entry_t *NetworkGetArpEntry(uint8_t ctrlId, const uint8_t *pIpAddr);
 static arp_entry_t *NetworkCreateArpEntry(uint8_t ctrlId);
@@ -111,28 +231,55 @@ static bool NetworkRequestArp(uint8_t ctrlId, const uint8_t *pIpAddr);
 static bool NetworkStoreArp(uint8_t ctrlId, const uint8_t *pIpAddr, const uint8_t *pMacAddr, bool hasDecay);
 static bool NetworkUpdateArpTable(uint8_t ctrlId, const uint8_t *pSourceIp, const uint8_t *pSourceMac, bool hasDecay);
 static bool NetworkProcessArpPacket(uint8_t ctrlId, uint8_t *pBuffer, uint16_t buffSize);
+// Checksum functions
+static uint16_t NetworkIpChecksum(const ipv4_header_t *pIpHeader);
+static void NetworkSetIpChecksum(uint8_t ctrlId, ipv4_header_t *pIpHeader);
+static uint32_t NetworkSumBytes(const uint8_t *pSrc, uint32_t size, uint32_t sum, bool isOdd);
+static uint32_t NetworkCopyAndSum(uint8_t *pDest, const uint8_t *pSrc, uint32_t size, uint32_t sum, bool isOdd);
+static uint32_t NetworkUdpHeaderSum(const uint8_t *pSrcIp, const uint8_t *pDstIp, uint16_t srcPort, uint16_t dstPort, uint16_t udpLength);
+static uint16_t NetworkUdpChecksum(uint8_t ctrlId, const network_msg_info_t *pMsgInfo);
 // Data send functions
 static bool NetworkSendEthPacket(uint8_t ctrlId, uint8_t *pBuffer, network_msg_info_t msgInfo);
 static bool NetworkSendIpPacket(uint8_t ctrlId, uint8_t protocol, uint8_t *pBuffer, network_msg_info_t msgInfo);
 static bool NetworkSendUdpPacket(uint8_t ctrlId, uint8_t *pBuffer, network_msg_info_t msgInfo);
+static bool NetworkSendUdpSegment(uint8_t ctrlId, uint8_t *pBuffer, network_msg_info_t msgInfo);
 // Icmp functions
-static uint16_t NetworkIcmpChecksum(const uint16_t *pBuffer, uint16_t buffSize);
-static uint16_t NetworkIcmpLength(uint8_t *pHeader, uint16_t ipMsgSize);
+static uint16_t NetworkIcmpLength(uint16_t ipMsgSize);
 static bool NetworkSendIcmpEchoRequest(uint8_t ctrlId, const uint8_t *pIpAdress);
 static bool NetworkProcessIcmpEchoRequest(uint8_t ctrlId, uint8_t *pBuffer, uint16_t buffSize);
 static bool NetworkProcessIcmpEchoReply(uint8_t ctrlId);
 static bool NetworkProcessIcmpPacket(uint8_t ctrlId, uint8_t *pBuffer, uint16_t buffSize);
+// Igmp functions
+static bool NetworkSendIgmpMessage(uint8_t ctrlId, uint8_t type, uint32_t groupWord);
+static bool NetworkProcessIgmpPacket(uint8_t ctrlId, uint8_t *pBuffer, uint16_t buffSize);
 // Store data functions
 static uint8_t *NetworkDecodeUdpPacket(uint8_t *pBuffer, uint16_t *pDataSize, uint16_t *pDestPort);
-static bool NetworkStoreSendData(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const uint8_t *pIpDest);
-static bool NetworkStoreIncMsg(const uint8_t *pBuffer, uint16_t buffSize, uint16_t destPort, uint8_t protocol, uint8_t *pIpSrc);
+static bool NetworkStoreSendData(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const uint8_t *pIpDest, uint16_t destPort);
+static bool NetworkReadTxData(uint8_t portId, uint8_t *pPayload, uint16_t payloadOffset, uint32_t fifoOffset, uint16_t size, uint32_t *pSum);
+static bool NetworkStorePortMsg(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const uint8_t *pIpSrc, uint16_t srcPort, const uint32_t *pHeaderSum);
+static bool NetworkStoreAggregatedMsg(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const uint8_t *pIpSrc, uint16_t srcPort, const uint32_t *pHeaderSum);
+static bool NetworkIsPortRecipient(uint8_t portId, uint16_t destPort, uint8_t protocol, const uint8_t *pPortMap);
+static void NetworkLinkConnPort(uint8_t portId);
+static void NetworkUnlinkConnPort(uint8_t portId);
+static uint8_t NetworkGetConnPort(const uint8_t *pIpSrc, uint16_t srcPort, uint16_t destPort, uint8_t protocol);
+static bool NetworkStoreIncMsg(const uint8_t *pBuffer, uint16_t buffSize, uint16_t destPort, uint8_t protocol, uint8_t *pIpSrc, uint16_t srcPort, const uint32_t *pHeaderSum, const uint8_t *pPortMap);
 // Process functions
+static uint16_t NetworkAggregateMsg(uint8_t portId, const network_msg_desc_t *pFirstDesc, const uint8_t *pDestIp, uint16_t *pMsgNb, uint16_t *pMsgSize);
+static bool NetworkReadAggregatedMsg(uint8_t portId, uint8_t *pData, uint16_t msgNb, uint32_t *pSum);
+static bool NetworkSendSegmentedMsg(uint8_t portId, uint8_t *pBuffer, network_msg_info_t msgInfo, uint16_t msgSize);
+static bool NetworkSendFragmentedMsg(uint8_t portId, uint8_t *pBuffer, network_msg_info_t msgInfo, uint16_t msgSize);
 static bool NetworkProcessSendMsg(uint8_t portId, uint8_t *pBuffer);
+static ip_reasm_ctx_t *NetworkGetReasmContext(uint8_t ctrlId, const ipv4_header_t *pIpHeader);
+static bool NetworkProcessIpFragment(uint8_t ctrlId, uint8_t *pBuffer, uint16_t buffSize);
+static bool NetworkProcessIpPayload(uint8_t ctrlId, uint8_t *pBuffer, uint16_t buffSize, bool isReassembled);
 static bool NetworkProcessIpPacket(uint8_t ctrlId, uint8_t *pBuffer, uint16_t buffSize);
 static bool NetworkProcessEthPacket(uint8_t ctrlId, uint8_t *pBuffer, uint16_t buffSize);
 // Check functions
 static bool NetworkCtrlValid(uint8_t ctrlId);
 static bool NetworkPortValid(uint8_t portId);
+static uint16_t NetworkGetEphemeralPort(void);
+static void *NetworkPortGetFifo(void *pFifo, uint32_t itemNb, uint32_t itemSize);
+static bool NetworkPortFifosFit(uint8_t portId, const network_port_desc_t *pPortDesc);
 static bool NetworkCheckGenItfc(const network_gen_itfc_t *pGenItfc);
 static bool NetworkCheckComItfc(const network_com_itfc_t *pComItfc);
 
@@ -159,56 +306,394 @@ static void NetworkInitMsgInfo(network_msg_info_t *pMsgInfo, const uint8_t *pIpA
     pMsgInfo->DstPort = dstPort;
     pMsgInfo->DataSize = dataSize;
     pMsgInfo->HeaderSize = 0;
+    pMsgInfo->PayloadSize = dataSize;
+    pMsgInfo->Identification = 0; // Atomic datagrams do not need an id (RFC 6864)
+    pMsgInfo->FragmentField = IPV4_FLAG_DF;
+    pMsgInfo->Dscp = NetworkPrioDscp[NETWORK_PRIO_BEST_EFFORT];
+    pMsgInfo->DataSum = 0;
+    pMsgInfo->HasUdpChecksum = false;
+    pMsgInfo->pDataSpans = NULL;
     memcpy(pMsgInfo->DstIP, pIpAddr, IP_ADDR_LENGTH);
 }
 
 /**
- * \fn static bool NetworkIsIpValid(const uint8_t *pIpAddr, const uint8_t *pRefIpAddr, const uint8_t *pSubnetMask)
- * \brief Returns the validity of an ip address for a given subnet
+ * \fn static uint32_t NetworkIpWord(const uint8_t *pIpAddr)
+ * \brief Returns an ip address as a memory order word
  *
- * \param pIpAddr pointer to the ip address to check
- * \param pRefIpAddr pointer to the ip address to use as reference
+ * \param pIpAddr pointer to the ip address (no alignment required)
+ * \return uint32_t: address word
+ */
+static uint32_t NetworkIpWord(const uint8_t *pIpAddr) {
+    uint32_t ipWord;
+
+    memcpy(&ipWord, pIpAddr, sizeof(ipWord));
+    return ipWord;
+}
+
+/**
+ * \fn static uint8_t NetworkIpHash(uint32_t ipWord)
+ * \brief Returns a hash of an ip address, for table indexing
+ *
+ * \param ipWord ip address (memory order word)
+ * \return uint8_t: address hash
+ */
+static uint8_t NetworkIpHash(uint32_t ipWord) {
+    return (uint8_t)(ipWord ^ (ipWord >> 8) ^ (ipWord >> 16) ^ (ipWord >> 24));
+}
+
+/**
+ * \fn static uint16_t NetworkFlowHash(const uint8_t *pSrcIp, uint16_t srcPort, uint16_t dstPort)
+ * \brief Returns a hash of a sender flow toward a local port, for load balancing and demultiplexing
+ *
+ * \param pSrcIp pointer to the sender ip address
+ * \param srcPort sender port
+ * \param dstPort local port
+ * \return uint16_t: flow hash
+ */
+static uint16_t NetworkFlowHash(const uint8_t *pSrcIp, uint16_t srcPort, uint16_t dstPort) {
+    // Multiplicative hashing, the high bits mix every input bit
+    return (uint16_t)(((NetworkIpWord(pSrcIp) ^ (((uint32_t)dstPort << 16) | srcPort)) * 0x9E3779B1u) >> 16);
+}
+
+/**
+ * \fn static void NetworkSetAddrInfo(ip_addr_info_t *pAddr, const uint8_t *pIpAddr, const uint8_t *pSubnetMask)
+ * \brief Fill a local address and its cached words
+ *
+ * \param pAddr pointer to the local address to fill
+ * \param pIpAddr pointer to the ip address
  * \param pSubnetMask pointer to the subnet mask
- * \return bool: true if ip address valid for this subnet
+ * \return void
  */
-static bool NetworkIsIpValid(const uint8_t *pIpAddr, const uint8_t *pRefIpAddr, const uint8_t *pSubnetMask) {
-    uint8_t maskedIpAddr[IP_ADDR_LENGTH] = {0,0,0,0};
-    uint8_t maskedRefIpAddr[IP_ADDR_LENGTH] = {0,0,0,0};
+static void NetworkSetAddrInfo(ip_addr_info_t *pAddr, const uint8_t *pIpAddr, const uint8_t *pSubnetMask) {
+    memcpy(pAddr->IpAddr, pIpAddr, IP_ADDR_LENGTH);
+    pAddr->IpAddrWord = NetworkIpWord(pIpAddr);
+    pAddr->SubnetMaskWord = NetworkIpWord(pSubnetMask);
+    pAddr->NetworkWord = pAddr->IpAddrWord & pAddr->SubnetMaskWord;
+    pAddr->BroadcastWord = pAddr->IpAddrWord | ~pAddr->SubnetMaskWord;
+}
 
-    // Mask the address
-    for (uint8_t i = 0; i < IP_ADDR_LENGTH; i++) {
-        maskedIpAddr[i] = pIpAddr[i] & pSubnetMask[i];
-        maskedRefIpAddr[i] = pRefIpAddr[i] & pSubnetMask[i];
+/**
+ * \fn static void NetworkUpdateCtrlAddr(network_ctrl_info_t *pNetworkCtrl)
+ * \brief Update the primary local address of a network controller
+ *
+ * \param pNetworkCtrl pointer to the network controller
+ * \return void
+ */
+static void NetworkUpdateCtrlAddr(network_ctrl_info_t *pNetworkCtrl) {
+    NetworkSetAddrInfo(&(pNetworkCtrl->pAddrArray[0]), pNetworkCtrl->IpAddr, pNetworkCtrl->SubnetMask);
+    NetworkFlushRouteCache(pNetworkCtrl);
+}
+
+/**
+ * \fn static const ip_addr_info_t *NetworkGetSubnetAddr(const uint8_t *pIpAddr, const network_ctrl_info_t *pNetworkCtrl)
+ * \brief Returns the first local address whose subnet contains an ip address
+ *
+ * \param pIpAddr pointer to the ip address
+ * \param pNetworkCtrl pointer to the network controller
+ * \return const ip_addr_info_t *: pointer to the local address, NULL if none
+ */
+static const ip_addr_info_t *NetworkGetSubnetAddr(const uint8_t *pIpAddr, const network_ctrl_info_t *pNetworkCtrl) {
+    uint32_t ipWord = NetworkIpWord(pIpAddr);
+
+    for (uint8_t addrIdx = 0; addrIdx < pNetworkCtrl->AddrNb; addrIdx++) {
+        if ((ipWord & pNetworkCtrl->pAddrArray[addrIdx].SubnetMaskWord) == pNetworkCtrl->pAddrArray[addrIdx].NetworkWord) {
+            return &(pNetworkCtrl->pAddrArray[addrIdx]);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \fn static const ip_addr_info_t *NetworkGetLocalAddr(const uint8_t *pIpAddr, const network_ctrl_info_t *pNetworkCtrl)
+ * \brief Returns the local address matching an ip address
+ *
+ * \param pIpAddr pointer to the ip address
+ * \param pNetworkCtrl pointer to the network controller
+ * \return const ip_addr_info_t *: pointer to the local address, NULL if the address is not local
+ */
+static const ip_addr_info_t *NetworkGetLocalAddr(const uint8_t *pIpAddr, const network_ctrl_info_t *pNetworkCtrl) {
+    uint32_t ipWord = NetworkIpWord(pIpAddr);
+
+    for (uint8_t addrIdx = 0; addrIdx < pNetworkCtrl->AddrNb; addrIdx++) {
+        if (ipWord == pNetworkCtrl->pAddrArray[addrIdx].IpAddrWord) {
+            return &(pNetworkCtrl->pAddrArray[addrIdx]);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \fn static const uint8_t *NetworkGetSrcIp(network_ctrl_info_t *pNetworkCtrl, const uint8_t *pDstIp)
+ * \brief Returns the source ip address to use toward a recipient
+ *
+ * \param pNetworkCtrl pointer to the network controller
+ * \param pDstIp pointer to the recipient ip address
+ * \return const uint8_t *: local address on the recipient (or its gateway) subnet, primary address by default
+ */
+static const uint8_t *NetworkGetSrcIp(network_ctrl_info_t *pNetworkCtrl, const uint8_t *pDstIp) {
+    const ip_addr_info_t *pAddr = NetworkGetSubnetAddr(pDstIp, pNetworkCtrl);
+    uint8_t nextHop[IP_ADDR_LENGTH];
+
+    if ((pAddr == NULL) && NetworkGetNextHop(pNetworkCtrl, pDstIp, nextHop)) {
+        pAddr = NetworkGetSubnetAddr(nextHop, pNetworkCtrl);
+    }
+    return (pAddr != NULL) ? pAddr->IpAddr : pNetworkCtrl->IpAddr;
+}
+
+/**
+ * \fn static void NetworkFlushRouteCache(network_ctrl_info_t *pNetworkCtrl)
+ * \brief Invalidate the route cache of a network controller, after an address or route change
+ *
+ * \param pNetworkCtrl pointer to the network controller
+ * \return void
+ */
+static void NetworkFlushRouteCache(network_ctrl_info_t *pNetworkCtrl) {
+    if (pNetworkCtrl->pRouteCache != NULL) {
+        memset(pNetworkCtrl->pRouteCache, 0, sizeof(route_cache_entry_t) * NETWORK_ROUTE_CACHE_SIZE);
     }
-    // Compare them
-    if (memcmp(maskedRefIpAddr, maskedIpAddr, sizeof(maskedIpAddr)) == 0) {
+}
+
+/**
+ * \fn static bool NetworkGetNextHop(network_ctrl_info_t *pNetworkCtrl, const uint8_t *pDstIp, uint8_t *pNextHop)
+ * \brief Returns the ip address a recipient is reached through (itself if on a controller subnet)
+ *
+ * \param pNetworkCtrl pointer to the network controller
+ * \param pDstIp pointer to the recipient ip address
+ * \param pNextHop pointer to the next hop ip address to fill
+ * \return bool: true if the recipient is reachable
+ */
+static bool NetworkGetNextHop(network_ctrl_info_t *pNetworkCtrl, const uint8_t *pDstIp, uint8_t *pNextHop) {
+    uint32_t dstWord = NetworkIpWord(pDstIp);
+
+    // On-link recipient or group
+    if (NetworkIsIpValid(pDstIp, pNetworkCtrl) || NetworkIsIpMulticast(pDstIp)) {
+        memcpy(pNextHop, pDstIp, IP_ADDR_LENGTH);
         return true;
-    } else {
+    }
+    if (pNetworkCtrl->RouteCount == 0) {
+        return false;
+    }
+    // Recent recipient
+    route_cache_entry_t *pCacheEntry = &(pNetworkCtrl->pRouteCache[NetworkIpHash(dstWord) & (NETWORK_ROUTE_CACHE_SIZE - 1)]);
+    if (pCacheEntry->IsValid && (pCacheEntry->DstWord == dstWord)) {
+        memcpy(pNextHop, &(pCacheEntry->NextHopWord), IP_ADDR_LENGTH);
+        return true;
+    }
+    // Longest prefix match, routes are sorted
+    for (uint8_t routeIdx = 0; routeIdx < pNetworkCtrl->RouteCount; routeIdx++) {
+        if ((dstWord & pNetworkCtrl->pRouteArray[routeIdx].MaskWord) == pNetworkCtrl->pRouteArray[routeIdx].NetworkWord) {
+            pCacheEntry->DstWord = dstWord;
+            pCacheEntry->NextHopWord = pNetworkCtrl->pRouteArray[routeIdx].GatewayWord;
+            pCacheEntry->IsValid = true;
+            memcpy(pNextHop, &(pCacheEntry->NextHopWord), IP_ADDR_LENGTH);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * \fn static bool NetworkSetRoute(network_ctrl_info_t *pNetworkCtrl, uint32_t netWord, uint32_t maskWord, const uint8_t *pGateway)
+ * \brief Add or replace a route, keeping the routes sorted by decreasing prefix length
+ *
+ * \param pNetworkCtrl pointer to the network controller
+ * \param netWord remote network address (memory order)
+ * \param maskWord remote network mask (memory order)
+ * \param pGateway pointer to the gateway ip address
+ * \return bool: true if set, false if the mask is not contiguous, the gateway is off-link or the table is full
+ */
+static bool NetworkSetRoute(network_ctrl_info_t *pNetworkCtrl, uint32_t netWord, uint32_t maskWord, const uint8_t *pGateway) {
+    uint8_t maskBytes[IP_ADDR_LENGTH];
+    uint32_t hostMask;
+    uint8_t prefixLength = 0;
+    uint8_t routeIdx;
+
+    memcpy(maskBytes, &maskWord, IP_ADDR_LENGTH);
+    hostMask = ((uint32_t)maskBytes[0] << 24) | ((uint32_t)maskBytes[1] << 16) | ((uint32_t)maskBytes[2] << 8) | maskBytes[3];
+    // Contiguous masks only
+    if (((~hostMask + 1) & ~hostMask) != 0) {
+        return false;
+    }
+    for (; (prefixLength < 32) && ((hostMask << prefixLength) & 0x80000000) != 0; prefixLength++);
+    if (!NetworkIsIpValid(pGateway, pNetworkCtrl)) {
         return false;
     }
+    // Replace the same prefix route or insert a new one, the last place is kept for the default gateway
+    if (!NetworkDeleteRoute(pNetworkCtrl, netWord & maskWord, maskWord) && (maskWord != 0)) {
+        bool hasGateway = (pNetworkCtrl->RouteCount > 0) && (pNetworkCtrl->pRouteArray[pNetworkCtrl->RouteCount - 1].MaskWord == 0);
+
+        if ((pNetworkCtrl->RouteCount - (hasGateway ? 1 : 0)) >= pNetworkCtrl->pDesc->RouteNb) {
+            return false;
+        }
+    }
+    for (routeIdx = pNetworkCtrl->RouteCount; (routeIdx > 0) && (pNetworkCtrl->pRouteArray[routeIdx - 1].PrefixLength < prefixLength); routeIdx--) {
+        pNetworkCtrl->pRouteArray[routeIdx] = pNetworkCtrl->pRouteArray[routeIdx - 1];
+    }
+    pNetworkCtrl->pRouteArray[routeIdx].NetworkWord = netWord & maskWord;
+    pNetworkCtrl->pRouteArray[routeIdx].MaskWord = maskWord;
+    pNetworkCtrl->pRouteArray[routeIdx].GatewayWord = NetworkIpWord(pGateway);
+    pNetworkCtrl->pRouteArray[routeIdx].PrefixLength = prefixLength;
+    pNetworkCtrl->RouteCount++;
+    NetworkFlushRouteCache(pNetworkCtrl);
+    return true;
+}
+
+/**
+ * \fn static bool NetworkDeleteRoute(network_ctrl_info_t *pNetworkCtrl, uint32_t netWord, uint32_t maskWord)
+ * \brief Remove a route, keeping the routes sorted
+ *
+ * \param pNetworkCtrl pointer to the network controller
+ * \param netWord remote network address (memory order)
+ * \param maskWord remote network mask (memory order)
+ * \return bool: true if removed
+ */
+static bool NetworkDeleteRoute(network_ctrl_info_t *pNetworkCtrl, uint32_t netWord, uint32_t maskWord) {
+    for (uint8_t routeIdx = 0; routeIdx < pNetworkCtrl->RouteCount; routeIdx++) {
+        if ((pNetworkCtrl->pRouteArray[routeIdx].NetworkWord == (netWord & maskWord)) && (pNetworkCtrl->pRouteArray[routeIdx].MaskWord == maskWord)) {
+            pNetworkCtrl->RouteCount--;
+            for (; routeIdx < pNetworkCtrl->RouteCount; routeIdx++) {
+                pNetworkCtrl->pRouteArray[routeIdx] = pNetworkCtrl->pRouteArray[routeIdx + 1];
+            }
+            NetworkFlushRouteCache(pNetworkCtrl);
+            return true;
+        }
+    }
+    return false;
 }
 
 /**
- * \fn static bool NetworkIsIpBroadcast(const uint8_t *pIpAddr, const uint8_t *pRefIpAddr, const uint8_t *pSubnetMask)
- * \brief Indicates if an ip is a broadcast address
+ * \fn static bool NetworkIsIpValid(const uint8_t *pIpAddr, const network_ctrl_info_t *pNetworkCtrl)
+ * \brief Returns the validity of an ip address for one of a network controller subnets
  *
  * \param pIpAddr pointer to the ip address to check
- * \param pRefIpAddr pointer to the ip address to use as reference
- * \param pSubnetMask pointer to the subnet mask
+ * \param pNetworkCtrl pointer to the network controller
+ * \return bool: true if ip address valid for a controller subnet
+ */
+static bool NetworkIsIpValid(const uint8_t *pIpAddr, const network_ctrl_info_t *pNetworkCtrl) {
+    return (NetworkGetSubnetAddr(pIpAddr, pNetworkCtrl) != NULL);
+}
+
+/**
+ * \fn static bool NetworkIsIpBroadcast(const uint8_t *pIpAddr, const network_ctrl_info_t *pNetworkCtrl)
+ * \brief Indicates if an ip is the broadcast address of one of a network controller subnets
+ *
+ * \param pIpAddr pointer to the ip address to check
+ * \param pNetworkCtrl pointer to the network controller
  * \return bool: true if ip address is broadcast address
  */
-static bool NetworkIsIpBroadcast(const uint8_t *pIpAddr, const uint8_t *pRefIpAddr, const uint8_t *pSubnetMask) {
-    uint8_t broadcastIpAddr[IP_ADDR_LENGTH] = {0,0,0,0};
+static bool NetworkIsIpBroadcast(const uint8_t *pIpAddr, const network_ctrl_info_t *pNetworkCtrl) {
+    uint32_t ipWord = NetworkIpWord(pIpAddr);
+    bool isBroadcast = false;
 
-    // Calculate the broadcast address
-    for (uint8_t i = 0; i < IP_ADDR_LENGTH; i++) {
-        broadcastIpAddr[i] = pRefIpAddr[i] | ~pSubnetMask[i];
+    for (uint8_t addrIdx = 0; addrIdx < pNetworkCtrl->AddrNb; addrIdx++) {
+        isBroadcast |= (ipWord == pNetworkCtrl->pAddrArray[addrIdx].BroadcastWord);
     }
-    // Compare them
-    if (memcmp(broadcastIpAddr, pIpAddr, sizeof(broadcastIpAddr)) == 0) {
-        return true;
-    } else {
-        return false;
+    return isBroadcast;
+}
+
+/**
+ * \fn static bool NetworkIsIpMulticast(const uint8_t *pIpAddr)
+ * \brief Indicates if an ip is a multicast group address (224.0.0.0/4)
+ *
+ * \param pIpAddr pointer to the ip address to check
+ * \return bool: true if ip address is a group address
+ */
+static bool NetworkIsIpMulticast(const uint8_t *pIpAddr) {
+    return ((pIpAddr[0] & 0xF0) == 0xE0);
+}
+
+/**
+ * \fn static uint8_t NetworkMcastMacHash(const uint8_t *pGroupAddr)
+ * \brief Returns the mac filter bit of a group, hashed from the 23 address bits its mac address keeps
+ *
+ * \param pGroupAddr pointer to the group address
+ * \return uint8_t: filter bit index (0 to 63)
+ */
+static uint8_t NetworkMcastMacHash(const uint8_t *pGroupAddr) {
+    return ((pGroupAddr[1] & 0x7F) ^ pGroupAddr[2] ^ pGroupAddr[3]) & 0x3F;
+}
+
+/**
+ * \fn static mcast_group_t *NetworkGetMcastGroup(const network_ctrl_info_t *pNetworkCtrl, uint32_t groupWord)
+ * \brief Lookup for a joined multicast group
+ *
+ * \param pNetworkCtrl pointer to the network controller
+ * \param groupWord group address (memory order word)
+ * \return mcast_group_t *: pointer to the group entry (NULL if not joined)
+ */
+static mcast_group_t *NetworkGetMcastGroup(const network_ctrl_info_t *pNetworkCtrl, uint32_t groupWord) {
+    uint8_t groupNb = pNetworkCtrl->pDesc->McastGroupNb;
+
+    // Groups are probed from their hash slot up to the first free entry
+    for (uint8_t probeNb = 0, groupIdx = (groupNb > 0) ? NetworkIpHash(groupWord) % groupNb : 0; probeNb < groupNb; probeNb++, groupIdx = (groupIdx + 1) % groupNb) {
+        mcast_group_t *pGroup = &(pNetworkCtrl->pMcastArray[groupIdx]);
+
+        if (pGroup->PortCount == 0) {
+            return NULL;
+        } else if (pGroup->GroupWord == groupWord) {
+            return pGroup;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \fn static mcast_group_t *NetworkAddMcastGroup(network_ctrl_info_t *pNetworkCtrl, uint32_t groupWord)
+ * \brief Take a free group entry for a new multicast group, the entry is used once a port subscribes
+ *
+ * \param pNetworkCtrl pointer to the network controller
+ * \param groupWord group address (memory order word)
+ * \return mcast_group_t *: pointer to the group entry (NULL if the table is full)
+ */
+static mcast_group_t *NetworkAddMcastGroup(network_ctrl_info_t *pNetworkCtrl, uint32_t groupWord) {
+    uint8_t groupNb = pNetworkCtrl->pDesc->McastGroupNb;
+
+    for (uint8_t probeNb = 0, groupIdx = (groupNb > 0) ? NetworkIpHash(groupWord) % groupNb : 0; probeNb < groupNb; probeNb++, groupIdx = (groupIdx + 1) % groupNb) {
+        mcast_group_t *pGroup = &(pNetworkCtrl->pMcastArray[groupIdx]);
+
+        if (pGroup->PortCount == 0) {
+            pGroup->GroupWord = groupWord;
+            memset(pGroup->pPortMap, 0, (NetworkInfo.pInitDesc->PortNb + 7) / 8);
+            return pGroup;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \fn static void NetworkRemoveMcastGroup(network_ctrl_info_t *pNetworkCtrl, mcast_group_t *pGroup)
+ * \brief Free a group entry without breaking the probe sequences of the next ones, then rebuild the mac filter
+ *
+ * \param pNetworkCtrl pointer to the network controller
+ * \param pGroup pointer to the group entry to free
+ * \return void
+ */
+static void NetworkRemoveMcastGroup(network_ctrl_info_t *pNetworkCtrl, mcast_group_t *pGroup) {
+    uint8_t groupNb = pNetworkCtrl->pDesc->McastGroupNb;
+    uint8_t groupIdx = (uint8_t)(pGroup - pNetworkCtrl->pMcastArray);
+
+    pGroup->PortCount = 0;
+    // Backward shift: following entries of the probe run move into the free entry if their hash slot is not after it
+    for (uint8_t nextIdx = (groupIdx + 1) % groupNb; pNetworkCtrl->pMcastArray[nextIdx].PortCount != 0; nextIdx = (nextIdx + 1) % groupNb) {
+        uint8_t homeIdx = NetworkIpHash(pNetworkCtrl->pMcastArray[nextIdx].GroupWord) % groupNb;
+
+        if (((nextIdx + groupNb - homeIdx) % groupNb) >= ((nextIdx + groupNb - groupIdx) % groupNb)) {
+            // Entries are swapped, port maps included, so each entry keeps one
+            mcast_group_t freeGroup = pNetworkCtrl->pMcastArray[groupIdx];
+
+            pNetworkCtrl->pMcastArray[groupIdx] = pNetworkCtrl->pMcastArray[nextIdx];
+            pNetworkCtrl->pMcastArray[nextIdx] = freeGroup;
+            groupIdx = nextIdx;
+        }
+    }
+    pNetworkCtrl->McastMacFilter = 0;
+    for (groupIdx = 0; groupIdx < groupNb; groupIdx++) {
+        if (pNetworkCtrl->pMcastArray[groupIdx].PortCount != 0) {
+            uint8_t groupAddr[IP_ADDR_LENGTH];
+
+            memcpy(groupAddr, &(pNetworkCtrl->pMcastArray[groupIdx].GroupWord), IP_ADDR_LENGTH);
+            pNetworkCtrl->McastMacFilter |= (uint64_t)1 << NetworkMcastMacHash(groupAddr);
+        }
     }
 }
 
@@ -223,18 +708,167 @@ static bool NetworkIsIpBroadcast(const uint8_t *pIpAddr, const uint8_t *pRefIpAd
 static bool NetworkAcceptIncIpPacket(uint8_t ctrlId, ipv4_header_t *pIpHeader) {
     network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[ctrlId]);
 
-    // Check if sender has valid ip for this subnet
-    if (NetworkIsIpValid(pIpHeader->srcIp, pNetworkCtrl->IpAddr, pNetworkCtrl->SubnetMask)) {
-        // Check if this packet concerns us
-        bool isBroadcast = NetworkIsIpBroadcast(pIpHeader->dstIp, pNetworkCtrl->IpAddr, pNetworkCtrl->SubnetMask);
-        bool destIsThis = (memcmp(pIpHeader->dstIp, pNetworkCtrl->IpAddr, IP_ADDR_LENGTH) == 0);
-        if (isBroadcast || destIsThis) {
-            return true;
+    uint32_t srcWord = NetworkIpWord(pIpHeader->srcIp);
+    uint32_t dstWord = NetworkIpWord(pIpHeader->dstIp);
+    bool isAccepted = false;
+
+    // Groups pass the mac filter before the group table lookup
+    if (NetworkIsIpMulticast(pIpHeader->dstIp)) {
+        return (dstWord == NetworkIpWord(NetworkMcastAllHosts)) || (((pNetworkCtrl->McastMacFilter >> NetworkMcastMacHash(pIpHeader->dstIp)) & 1) && (NetworkGetMcastGroup(pNetworkCtrl, dstWord) != NULL));
+    }
+    // Sender must be on the subnet of the address or broadcast it targets
+    for (uint8_t addrIdx = 0; addrIdx < pNetworkCtrl->AddrNb; addrIdx++) {
+        const ip_addr_info_t *pAddr = &(pNetworkCtrl->pAddrArray[addrIdx]);
+        isAccepted |= ((srcWord & pAddr->SubnetMaskWord) == pAddr->NetworkWord) & ((dstWord == pAddr->IpAddrWord) | (dstWord == pAddr->BroadcastWord));
+    }
+    // Senders behind a gateway must target a local address and be reachable back
+    if (!isAccepted && (pNetworkCtrl->RouteCount > 0) && (NetworkGetLocalAddr(pIpHeader->dstIp, pNetworkCtrl) != NULL)) {
+        uint8_t nextHop[IP_ADDR_LENGTH];
+        isAccepted = NetworkGetNextHop(pNetworkCtrl, pIpHeader->srcIp, nextHop);
+    }
+    return isAccepted;
+}
+
+/**
+ * \fn static void NetworkSortTxPorts(void)
+ * \brief Sort the network ports transmission order by decreasing priority class (stable on port id)
+ *
+ * \return void
+ */
+static void NetworkSortTxPorts(void) {
+    uint8_t orderIdx = 0;
+
+    for (int8_t prio = NETWORK_PRIO_NB - 1; prio >= 0; prio--) {
+        for (uint8_t portId = 0; portId < NetworkInfo.pInitDesc->PortNb; portId++) {
+            const network_port_desc_t *pDesc = NetworkInfo.pPortInfoList[portId].pDesc;
+            uint8_t portPrio = (pDesc != NULL) ? pDesc->Priority : NETWORK_PRIO_BEST_EFFORT;
+
+            if (portPrio == prio) {
+                NetworkInfo.pTxPortOrder[orderIdx++] = portId;
+            }
+        }
+    }
+}
+
+/**
+ * \fn static uint32_t NetworkPortTxPending(uint8_t portId)
+ * \brief Returns a network port pending transmission amount, used to detect transmission progress
+ *
+ * \param portId network port id
+ * \return uint32_t: sum of the data and descriptor fifo item counts
+ */
+static uint32_t NetworkPortTxPending(uint8_t portId) {
+    return FifoItemCount(NetworkInfo.pPortInfoList[portId].pFifoTxMsg) + FifoItemCount(NetworkInfo.pPortInfoList[portId].pFifoTxMsgDesc);
+}
+
+/**
+ * \fn static bool NetworkShaperAllow(uint8_t portId, uint32_t frameSize)
+ * \brief Refill a network port token bucket and check if a frame can be sent (tokens are taken if so)
+ *
+ * \param portId network port id
+ * \param frameSize size of the frame to send (bytes)
+ * \return bool: true if the frame can be sent now
+ */
+static bool NetworkShaperAllow(uint8_t portId, uint32_t frameSize) {
+    network_port_info_t *pNetworkPort = &(NetworkInfo.pPortInfoList[portId]);
+    uint32_t rateLimit = pNetworkPort->pDesc->TxRateLimit;
+    int32_t maxTokens = (int32_t)pNetworkPort->pDesc->TxBurstSize * 1000;
+
+    // Unshaped port
+    if (rateLimit == 0) {
+        return true;
+    }
+    // Refill the bucket (bytes/s * ms = milli-bytes)
+    uint32_t currTime = NetworkInfo.pInitDesc->GenInterface.pFnTimerGetTime();
+    int64_t tokens = (int64_t)pNetworkPort->ShaperTokens + ((int64_t)rateLimit * UtilsDiffUint32(pNetworkPort->ShaperTime, currTime));
+    pNetworkPort->ShaperTokens = (tokens > maxTokens) ? maxTokens : (int32_t)tokens;
+    pNetworkPort->ShaperTime = currTime;
+    // Frames bigger than the burst size are sent when the bucket is full
+    int32_t neededTokens = (int32_t)frameSize * 1000;
+    if (pNetworkPort->ShaperTokens >= ((neededTokens < maxTokens) ? neededTokens : maxTokens)) {
+        pNetworkPort->ShaperTokens -= neededTokens;
+        // Account for the delay if traffic was held back
+        if (pNetworkPort->IsShaperHolding) {
+            pNetworkPort->Stats.ShaperDelay += UtilsDiffUint32(pNetworkPort->ShaperHoldTime, currTime);
+            pNetworkPort->IsShaperHolding = false;
         }
+        return true;
+    }
+    if (!pNetworkPort->IsShaperHolding) {
+        pNetworkPort->ShaperHoldTime = currTime;
+        pNetworkPort->Stats.ShaperHoldNb++;
+        pNetworkPort->IsShaperHolding = true;
     }
     return false;
 }
 
+/**
+ * \fn static void NetworkShaperRefund(uint8_t portId, uint32_t frameSize)
+ * \brief Give back to a network port token bucket the tokens taken for a frame that could not be sent
+ *
+ * \param portId network port id
+ * \param frameSize size of the frame that was not sent (bytes)
+ */
+static void NetworkShaperRefund(uint8_t portId, uint32_t frameSize) {
+    network_port_info_t *pNetworkPort = &(NetworkInfo.pPortInfoList[portId]);
+
+    // Shaped port only
+    if (pNetworkPort->pDesc->TxRateLimit != 0) {
+        pNetworkPort->ShaperTokens += (int32_t)frameSize * 1000;
+    }
+}
+
+/**
+ * \fn static uint16_t NetworkPortMaxDataSize(uint8_t portId)
+ * \brief Returns the max udp data size of an unfragmented datagram on a network port controller
+ *
+ * \param portId network port id
+ * \return uint16_t: max data size (bytes)
+ */
+static uint16_t NetworkPortMaxDataSize(uint8_t portId) {
+    return NetworkInfo.pCtrlInfoList[NetworkInfo.pPortInfoList[portId].pDesc->NetworkCtrlId].MaxDataSize;
+}
+
+/**
+ * \fn static uint16_t NetworkPortMaxMsgSize(uint8_t portId)
+ * \brief Returns the max message size a descriptor mode network port accepts
+ *
+ * \param portId network port id
+ * \return uint16_t: max message size (bytes)
+ */
+static uint16_t NetworkPortMaxMsgSize(uint8_t portId) {
+    if ((NetworkInfo.pPortInfoList[portId].pDesc->Options & NETWORK_PORT_OPT_FRAGMENT) != 0) {
+        return (uint16_t)UDP_MAX_DATA_SIZE;
+    }
+    if ((NetworkInfo.pPortInfoList[portId].pDesc->Options & NETWORK_PORT_OPT_SEGMENT) != 0) {
+        return UINT16_MAX;
+    }
+    if ((NetworkInfo.pPortInfoList[portId].pDesc->Options & NETWORK_PORT_OPT_AGGREGATE) != 0) {
+        return (uint16_t)(NetworkPortMaxDataSize(portId) - NETWORK_AGGREGATE_PREFIX_SIZE);
+    }
+    return NetworkPortMaxDataSize(portId);
+}
+
+/**
+ * \fn static void NetworkGetMsgDestIp(uint8_t portId, const network_msg_desc_t *pMsgDesc, uint8_t *pDestIp)
+ * \brief Returns the recipient ip address of a stored message
+ *
+ * \param portId network port id
+ * \param pMsgDesc pointer to the message descriptor
+ * \param pDestIp pointer to contain the recipient ip address
+ * \return void
+ */
+static void NetworkGetMsgDestIp(uint8_t portId, const network_msg_desc_t *pMsgDesc, uint8_t *pDestIp) {
+    const uint8_t nullIp[IP_ADDR_LENGTH] = {0,0,0,0};
+
+    // Send to descriptor dest ip address if valid
+    if (memcmp(nullIp, pMsgDesc->IpAddr, IP_ADDR_LENGTH) != 0) {
+        memcpy(pDestIp, pMsgDesc->IpAddr, IP_ADDR_LENGTH);
+    } else { // Send to default dest ip address otherwise
+        memcpy(pDestIp, NetworkInfo.pPortInfoList[portId].DstIpAddr, IP_ADDR_LENGTH);
+    }
+}
+
 /**
  * \fn static arp_entry_t *NetworkGetArpEntry(uint8_t ctrlId, const uint8_t *pIpAddr)
  * \brief Lookup for a given IP address in a network controller arp table
@@ -315,6 +949,7 @@ static bool NetworkRequestArp(uint8_t ctrlId, const uint8_t *pIpAddr) {
     }
     // Create arp request
     uint8_t msgBuffer[ETH_HEADER_SIZE + ARP_HEADER_SIZE]; // 42 bytes
+    const uint8_t *pSrcIp = NetworkGetSrcIp(pNetworkCtrl, pIpAddr);
     ethernet_header_t *pEthHeader = (ethernet_header_t *)msgBuffer;
     arp_header_t *pArpHeader = (arp_header_t *)(msgBuffer + ETH_HEADER_SIZE);
 
@@ -327,7 +962,7 @@ static bool NetworkRequestArp(uint8_t ctrlId, const uint8_t *pIpAddr) {
     }
     // Fill ip address
     for (uint8_t i = 0; i < IP_ADDR_LENGTH; i++) {
-        pArpHeader->senderIp[i] = pNetworkCtrl->IpAddr[i];
+        pArpHeader->senderIp[i] = pSrcIp[i];
         pArpHeader->targetIp[i] = pIpAddr[i];
     }
     // Fill misc
@@ -429,13 +1064,15 @@ static bool NetworkUpdateArpTable(uint8_t ctrlId, const uint8_t *pSourceIp, cons
     ethernet_header_t *pEthHeader = (ethernet_header_t*) pBuffer;
     arp_header_t *pArpHeader = (arp_header_t *)(pBuffer + ETH_HEADER_SIZE);
     uint16_t operation = SWAP16(pArpHeader->operation);
+    const ip_addr_info_t *pLocalAddr;
 
     // Process only if ip address valid for the subnet
-    if (NetworkIsIpValid(pArpHeader->senderIp, pNetworkCtrl->IpAddr, pNetworkCtrl->SubnetMask)) {
+    if (NetworkIsIpValid(pArpHeader->senderIp, pNetworkCtrl)) {
         switch(operation) {
             case ARP_REQUEST:
-                // Check if arp concerns the controller
-                if (memcmp(pArpHeader->targetIp, pNetworkCtrl->IpAddr, IP_ADDR_LENGTH) == 0) {
+                // Check if arp concerns one of the controller addresses
+                pLocalAddr = NetworkGetLocalAddr(pArpHeader->targetIp, pNetworkCtrl);
+                if (pLocalAddr != NULL) {
                     pArpHeader->operation = SWAP16(ARP_REPLY);
                     // Swap destination and source mac address
                     for (uint8_t i = 0; i < 6; i++) {
@@ -447,7 +1084,7 @@ static bool NetworkUpdateArpTable(uint8_t ctrlId, const uint8_t *pSourceIp, cons
                     // Swap destination and source ip address
                     for (uint8_t i = 0; i < 4; i++) {
                         pArpHeader->targetIp[i] = pArpHeader->senderIp[i];
-                        pArpHeader->senderIp[i] = pNetworkCtrl->IpAddr[i];
+                        pArpHeader->senderIp[i] = pLocalAddr->IpAddr[i];
                     }
                     // Send reply
                     return pNetworkCtrl->pDesc->ComInterface.MacCtrlSendMsg(pNetworkCtrl->pDesc->MacCtrlId, pBuffer, buffSize);
@@ -471,6 +1108,118 @@ static bool NetworkUpdateArpTable(uint8_t ctrlId, const uint8_t *pSourceIp, cons
     }
 }
 
+/**
+ * \fn static uint16_t NetworkIpChecksum(const ipv4_header_t *pIpHeader)
+ * \brief Returns an ipv4 header checksum (0 when computed over a valid header)
+ *
+ * \param pIpHeader pointer to the ipv4 header
+ * \return uint16_t: header checksum (memory order)
+ */
+static uint16_t NetworkIpChecksum(const ipv4_header_t *pIpHeader) {
+    return UtilsRotrUint16(UtilsInetChecksum((const uint8_t *)pIpHeader, (uint32_t)pIpHeader->ihl * 4), 8);
+}
+
+/**
+ * \fn static void NetworkSetIpChecksum(uint8_t ctrlId, ipv4_header_t *pIpHeader)
+ * \brief Fill an ipv4 header checksum unless the mac controller does it
+ *
+ * \param ctrlId network controller id
+ * \param pIpHeader pointer to the ipv4 header
+ * \return void
+ */
+static void NetworkSetIpChecksum(uint8_t ctrlId, ipv4_header_t *pIpHeader) {
+    if ((NetworkInfo.pCtrlInfoList[ctrlId].pDesc->ComInterface.Capabilities & NETWORK_CAP_TX_IPV4_CKSUM) == 0) {
+        pIpHeader->checksum = 0;
+        pIpHeader->checksum = NetworkIpChecksum(pIpHeader);
+    }
+}
+
+/**
+ * \fn static uint32_t NetworkSumBytes(const uint8_t *pSrc, uint32_t size, uint32_t sum, bool isOdd)
+ * \brief Add bytes to a one's complement sum of big endian words
+ *
+ * \param pSrc pointer to the data
+ * \param size data size
+ * \param sum sum to add the data to
+ * \param isOdd true if the data starts at an odd position of the summed area
+ * \return uint32_t: updated sum (not folded)
+ */
+static uint32_t NetworkSumBytes(const uint8_t *pSrc, uint32_t size, uint32_t sum, bool isOdd) {
+    // Odd start, the first byte is the low part of a word
+    if (isOdd && (size > 0)) {
+        sum += *pSrc++;
+        size--;
+    }
+    return sum + UtilsInetSum(pSrc, size, 0);
+}
+
+/**
+ * \fn static uint32_t NetworkCopyAndSum(uint8_t *pDest, const uint8_t *pSrc, uint32_t size, uint32_t sum, bool isOdd)
+ * \brief Copy bytes and add them to a one's complement sum of big endian words in the same pass
+ *
+ * \param pDest pointer to the copy destination
+ * \param pSrc pointer to the data
+ * \param size data size
+ * \param sum sum to add the data to
+ * \param isOdd true if the data starts at an odd position of the summed area
+ * \return uint32_t: updated sum (not folded)
+ */
+static uint32_t NetworkCopyAndSum(uint8_t *pDest, const uint8_t *pSrc, uint32_t size, uint32_t sum, bool isOdd) {
+    // Odd start, the first byte is the low part of a word
+    if (isOdd && (size > 0)) {
+        *pDest++ = *pSrc;
+        sum += *pSrc++;
+        size--;
+    }
+    for (; size > 1; size -= 2, pSrc += 2, pDest += 2) {
+        pDest[0] = pSrc[0];
+        pDest[1] = pSrc[1];
+        sum += ((uint32_t)pSrc[0] << 8) | pSrc[1];
+    }
+    // Trailing byte is the high part of a word
+    if (size > 0) {
+        *pDest = *pSrc;
+        sum += (uint32_t)*pSrc << 8;
+    }
+    return sum;
+}
+
+/**
+ * \fn static uint32_t NetworkUdpHeaderSum(const uint8_t *pSrcIp, const uint8_t *pDstIp, uint16_t srcPort, uint16_t dstPort, uint16_t udpLength)
+ * \brief Returns the one's complement sum of an udp pseudo header and header (checksum field excluded)
+ *
+ * \param pSrcIp pointer to the source ip address
+ * \param pDstIp pointer to the recipient ip address
+ * \param srcPort source port
+ * \param dstPort destination port
+ * \param udpLength udp length (header + data)
+ * \return uint32_t: sum (not folded)
+ */
+static uint32_t NetworkUdpHeaderSum(const uint8_t *pSrcIp, const uint8_t *pDstIp, uint16_t srcPort, uint16_t dstPort, uint16_t udpLength) {
+    uint32_t sum = NetworkSumBytes(pSrcIp, IP_ADDR_LENGTH, 0, false);
+
+    sum = NetworkSumBytes(pDstIp, IP_ADDR_LENGTH, sum, false);
+    // Pseudo header protocol and length, then header ports and length
+    sum += (uint32_t)IP_PROT_UDP + udpLength + srcPort + dstPort + udpLength;
+    return sum;
+}
+
+/**
+ * \fn static uint16_t NetworkUdpChecksum(uint8_t ctrlId, const network_msg_info_t *pMsgInfo)
+ * \brief Returns the udp checksum of a message
+ *
+ * \param ctrlId network controller id
+ * \param pMsgInfo pointer to the message network parameters (data sum included)
+ * \return uint16_t: udp checksum (host order)
+ */
+static uint16_t NetworkUdpChecksum(uint8_t ctrlId, const network_msg_info_t *pMsgInfo) {
+    uint32_t sum = NetworkUdpHeaderSum(NetworkGetSrcIp(&(NetworkInfo.pCtrlInfoList[ctrlId]), pMsgInfo->DstIP), pMsgInfo->DstIP, pMsgInfo->SrcPort, pMsgInfo->DstPort, pMsgInfo->PayloadSize + (uint16_t)UDP_HEADER_SIZE);
+    uint16_t checksum = (uint16_t)~UtilsInetFold((uint64_t)sum + pMsgInfo->DataSum);
+
+    // A zero checksum means no checksum, its one's complement equivalent is sent instead
+    return (checksum != 0) ? checksum : 0xFFFF;
+}
+
 /**
  * \fn static bool NetworkSendEthPacket(uint8_t ctrlId, uint8_t *pBuffer, network_msg_info_t msgInfo)
  * \brief Send an ethernet packet to the mac interface
@@ -482,20 +1231,36 @@ static bool NetworkUpdateArpTable(uint8_t ctrlId, const uint8_t *pSourceIp, cons
  */
 static bool NetworkSendEthPacket(uint8_t ctrlId, uint8_t *pBuffer, network_msg_info_t msgInfo) {
     network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[ctrlId]);
-    arp_entry_t *pArpEntry = NetworkGetArpEntry(ctrlId, (uint8_t *)msgInfo.DstIP);
+    uint8_t nextHop[IP_ADDR_LENGTH];
+    arp_entry_t *pArpEntry = NetworkGetNextHop(pNetworkCtrl, msgInfo.DstIP, nextHop) ? NetworkGetArpEntry(ctrlId, nextHop) : NULL;
     ethernet_header_t *pEthHeader = (ethernet_header_t *) pBuffer;
+    bool isBroadcast = NetworkIsIpBroadcast(msgInfo.DstIP, pNetworkCtrl);
+    bool isMulticast = NetworkIsIpMulticast(msgInfo.DstIP);
 
     // Check if we know where to send the packet
-    if (((pArpEntry != NULL) && pArpEntry->Status.IsValid) || NetworkIsIpBroadcast(msgInfo.DstIP, pNetworkCtrl->IpAddr, pNetworkCtrl->SubnetMask)) {
+    if (((pArpEntry != NULL) && pArpEntry->Status.IsValid) || isBroadcast || isMulticast) {
         // Set the source and destination mac adresses
         memcpy(pEthHeader->srcMac, pNetworkCtrl->MacAddr, MAC_ADDR_LENGTH);
-        if (!NetworkIsIpBroadcast(msgInfo.DstIP, pNetworkCtrl->IpAddr, pNetworkCtrl->SubnetMask))
+        if (isMulticast) {
+            // Group mac address: 01:00:5e followed by the 23 low bits of the group address
+            const uint8_t mcastMac[MAC_ADDR_LENGTH] = {0x01, 0x00, 0x5E, msgInfo.DstIP[1] & 0x7F, msgInfo.DstIP[2], msgInfo.DstIP[3]};
+            memcpy(pEthHeader->dstMac, mcastMac, MAC_ADDR_LENGTH);
+        } else if (!isBroadcast)
             memcpy(pEthHeader->dstMac, pArpEntry->MacAddr, MAC_ADDR_LENGTH);
         else
             memset(pEthHeader->dstMac, 0xFF, MAC_ADDR_LENGTH);
         // Network type 2 frame
         pEthHeader->lengthOrType = 0x0008; // UtilsRotrUint16(0x0800, 8);
         msgInfo.HeaderSize += (uint16_t)ETH_HEADER_SIZE;
+        // Gather headers and fifo data without copy
+        if (msgInfo.pDataSpans != NULL) {
+            network_sg_entry_t entries[3] = {
+                {pBuffer, msgInfo.HeaderSize},
+                {msgInfo.pDataSpans[0].pData, (uint16_t)msgInfo.pDataSpans[0].ItemNb},
+                {msgInfo.pDataSpans[1].pData, (uint16_t)msgInfo.pDataSpans[1].ItemNb},
+            };
+            return pNetworkCtrl->pDesc->ComInterface.MacCtrlSendMsgSg(pNetworkCtrl->pDesc->MacCtrlId, entries, (entries[2].Size > 0) ? 3 : 2);
+        }
         // Send packet
         return pNetworkCtrl->pDesc->ComInterface.MacCtrlSendMsg(pNetworkCtrl->pDesc->MacCtrlId, pBuffer, msgInfo.HeaderSize + msgInfo.DataSize);
     } else {
@@ -521,15 +1286,16 @@ static bool NetworkSendIpPacket(uint8_t ctrlId, uint8_t protocol, uint8_t *pBuff
     pIpHeader->ihl = 5; // internet header length (uint32_t)
     pIpHeader->version = 4; // ipv4
     pIpHeader->ecn = 0; // Do not support explicit congestion notification
-    pIpHeader->dscp = 0; // Best effort
+    pIpHeader->dscp = msgInfo.Dscp; // Port priority class
     pIpHeader->length = UtilsRotrUint16(((uint16_t)IPV4_HEADER_SIZE + msgInfo.DataSize + msgInfo.HeaderSize), 8); // Total size (data + header)
-    pIpHeader->identification = 0; // No id
-    pIpHeader->fragmentOffsetAndFlags = 64; // (2 << 5) + 0; // No fragment offset nor fragmentation
-    pIpHeader->ttl = 128;  // Time to live (hop count)
+    pIpHeader->identification = UtilsRotrUint16(msgInfo.Identification, 8); // Datagram id
+    pIpHeader->fragmentOffsetAndFlags = UtilsRotrUint16(msgInfo.FragmentField, 8); // Flags and fragment offset
+    pIpHeader->ttl = NetworkIsIpMulticast(msgInfo.DstIP) ? NETWORK_MCAST_TTL : 128;  // Time to live (hop count)
     pIpHeader->protocol = protocol; // Ip message protocole
-    pIpHeader->checksum = 0; // Packet checksum (hw calculated)
-    memcpy(pIpHeader->srcIp, pNetworkCtrl->IpAddr, IP_ADDR_LENGTH); // Source ip address
+    pIpHeader->checksum = 0; // Packet checksum (hw calculated if offloaded)
+    memcpy(pIpHeader->srcIp, NetworkGetSrcIp(pNetworkCtrl, msgInfo.DstIP), IP_ADDR_LENGTH); // Source ip address
     memcpy(pIpHeader->dstIp, msgInfo.DstIP, IP_ADDR_LENGTH); // Recipient ip address
+    NetworkSetIpChecksum(ctrlId, pIpHeader);
     msgInfo.HeaderSize += (uint16_t)IPV4_HEADER_SIZE; // We take into account the ipv4 header
     // Send packet
     return NetworkSendEthPacket(ctrlId, pBuffer, msgInfo);
@@ -549,48 +1315,50 @@ static bool NetworkSendUdpPacket(uint8_t ctrlId, uint8_t *pBuffer, network_msg_i
 
     pUdpHeader->srcPort = UtilsRotrUint16(msgInfo.SrcPort, 8); // Source port
     pUdpHeader->dstPort = UtilsRotrUint16(msgInfo.DstPort, 8); // Destination port
-    pUdpHeader->length = UtilsRotrUint16((msgInfo.DataSize + (uint16_t)UDP_HEADER_SIZE), 8); // Total size (data + header)
-    pUdpHeader->checksum = 0; // Packet checksum (hw calculated)
+    pUdpHeader->length = UtilsRotrUint16((msgInfo.PayloadSize + (uint16_t)UDP_HEADER_SIZE), 8); // Total size (data + header)
+    pUdpHeader->checksum = msgInfo.HasUdpChecksum ? UtilsRotrUint16(NetworkUdpChecksum(ctrlId, &msgInfo), 8) : 0; // Packet checksum (optional)
     msgInfo.HeaderSize = UDP_HEADER_SIZE; // We take into account the udp header
 
     return NetworkSendIpPacket(ctrlId, IP_PROT_UDP, pBuffer, msgInfo);
 }
 
 /**
- * \fn static uint16_t NetworkIcmpChecksum(const uint16_t *pBuffer, uint16_t buffSize)
- * \brief Return an icmp packet checksum
+ * \fn static bool NetworkSendUdpSegment(uint8_t ctrlId, uint8_t *pBuffer, network_msg_info_t msgInfo)
+ * \brief Send the next segment of a message, reusing the headers of the previous segment
  *
- * \param pBuffer: pointer to the data buffer
- * \param buffSize: buffer size
- * \return uint16_t: icmp checksum
+ * \param ctrlId  network controller id
+ * \param pBuffer pointer to the buffer to send (headers already filled)
+ * \param msgInfo segment network parameters
+ * \return bool: true if packet is sent successfully
  */
-static uint16_t NetworkIcmpChecksum(const uint16_t *pBuffer, uint16_t buffSize) {
-    uint32_t checksum = 0;
+static bool NetworkSendUdpSegment(uint8_t ctrlId, uint8_t *pBuffer, network_msg_info_t msgInfo) {
+    uint16_t dataSize = msgInfo.DataSize;
+    network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[ctrlId]);
+    ipv4_header_t *pIpHeader = (ipv4_header_t *)(pBuffer + ETH_HEADER_SIZE);
+    udp_header_t *pUdpHeader = (udp_header_t *)(pBuffer + IPV4_HEADER_SIZE + ETH_HEADER_SIZE);
 
-    for (uint16_t i = 0; i < buffSize; i++, pBuffer++) {
-        checksum += SWAP16(*pBuffer);
+    // Only the length fields change between segments
+    uint16_t ipLength = UtilsRotrUint16(((uint16_t)IPV4_HEADER_SIZE + (uint16_t)UDP_HEADER_SIZE + dataSize), 8);
+    if ((pNetworkCtrl->pDesc->ComInterface.Capabilities & NETWORK_CAP_TX_IPV4_CKSUM) == 0) {
+        pIpHeader->checksum = UtilsInetChecksumUpdate(pIpHeader->checksum, pIpHeader->length, ipLength);
     }
-    checksum = (checksum & 0xffff) + (checksum >> 16);
-    return (uint16_t)(~checksum);
+    pIpHeader->length = ipLength;
+    pUdpHeader->length = UtilsRotrUint16((dataSize + (uint16_t)UDP_HEADER_SIZE), 8);
+    if (msgInfo.HasUdpChecksum) {
+        pUdpHeader->checksum = UtilsRotrUint16(NetworkUdpChecksum(ctrlId, &msgInfo), 8);
+    }
+    return pNetworkCtrl->pDesc->ComInterface.MacCtrlSendMsg(pNetworkCtrl->pDesc->MacCtrlId, pBuffer, (uint16_t)NETWORK_HEADER_SIZE + dataSize);
 }
 
 /**
- * \fn static uint16_t NetworkIcmpLength(uint8_t *pHeader, uint16_t ipMsgSize)
+ * \fn static uint16_t NetworkIcmpLength(uint16_t ipMsgSize)
  * \brief Return an icmp packet length
  *
- * \param pHeader pointer to icmp header
- * \param ipMsgSize ip message size
- * \return uint16_t: icmp length
+ * \param ipMsgSize ip message size (network order)
+ * \return uint16_t: icmp length (bytes)
  */
-static uint16_t NetworkIcmpLength(uint8_t *pHeader, uint16_t ipMsgSize) {
-    uint16_t icmpMsgSize = (SWAP16(ipMsgSize) - (uint16_t)IPV4_HEADER_SIZE);
-
-    // Add data if size is odd
-    if ((icmpMsgSize % 2) > 0) {
-         *(pHeader + icmpMsgSize) = 0;
-         icmpMsgSize++;
-    }
-    return (icmpMsgSize / sizeof(uint16_t));
+static uint16_t NetworkIcmpLength(uint16_t ipMsgSize) {
+    return (SWAP16(ipMsgSize) - (uint16_t)IPV4_HEADER_SIZE);
 }
 
 /**
@@ -622,7 +1390,7 @@ static bool NetworkSendIcmpEchoRequest(uint8_t ctrlId, const uint8_t *pIpAdress)
     memset(pIcmpData, 0x5, NETWORK_ICMP_DATA_SIZE);
     // Icmp checksum calculation
     msgLength = UtilsRotrUint16((sizeof(bufferRequest) - ETH_HEADER_SIZE), 8);
-    pIcmpHeader->cksum = SWAP16(NetworkIcmpChecksum((uint16_t *)pIcmpHeader, NetworkIcmpLength((uint8_t *)pIcmpHeader, msgLength)));
+    pIcmpHeader->cksum = UtilsRotrUint16(UtilsInetChecksum((uint8_t *)pIcmpHeader, NetworkIcmpLength(msgLength)), 8);
     msgInfo.HeaderSize += (uint16_t)ICMP_HEADER_SIZE; // We take into account the icmp header
     // Get send time for delay calculation
     pNetworkCtrl->IcmpReplyDelay = NetworkInfo.pInitDesc->GenInterface.pFnTimerGetTime();
@@ -649,17 +1417,20 @@ static bool NetworkProcessIcmpEchoRequest(uint8_t ctrlId, uint8_t *pBuffer, uint
     pIcmpHeader->code = 0;
     pIcmpHeader->cksum = 0;
     // Icmp checksum calculation
-    pIcmpHeader->cksum = SWAP16(NetworkIcmpChecksum((uint16_t *)pIcmpHeader, NetworkIcmpLength((uint8_t *)pIcmpHeader, pIpHeader->length)));
-    // Swap destination and source ip address
+    pIcmpHeader->cksum = UtilsRotrUint16(UtilsInetChecksum((uint8_t *)pIcmpHeader, NetworkIcmpLength(pIpHeader->length)), 8);
+    // Swap destination and source ip address, answering from the requested address
+    const ip_addr_info_t *pLocalAddr = NetworkGetLocalAddr(pIpHeader->dstIp, pNetworkCtrl);
+    const uint8_t *pSrcIp = (pLocalAddr != NULL) ? pLocalAddr->IpAddr : NetworkGetSrcIp(pNetworkCtrl, pIpHeader->srcIp);
     for (uint8_t idx = 0; idx < 4; idx++) {
         pIpHeader->dstIp[idx] = pIpHeader->srcIp[idx];
-        pIpHeader->srcIp[idx] = pNetworkCtrl->IpAddr[idx];
+        pIpHeader->srcIp[idx] = pSrcIp[idx];
     }
     // Swap destination and source mac address
     for (uint8_t idx = 0; idx < 6; idx++) {
         p_eth->dstMac[idx] = p_eth->srcMac[idx];
         p_eth->srcMac[idx] = pNetworkCtrl->MacAddr[idx];
     }
+    NetworkSetIpChecksum(ctrlId, pIpHeader);
     // Send the echo_reply
     return pNetworkCtrl->pDesc->ComInterface.MacCtrlSendMsg(pNetworkCtrl->pDesc->MacCtrlId, pBuffer, buffSize);
 }
@@ -710,6 +1481,64 @@ static bool NetworkProcessIcmpPacket(uint8_t ctrlId, uint8_t *pBuffer, uint16_t
     }
 }
 
+/**
+ * \fn static bool NetworkSendIgmpMessage(uint8_t ctrlId, uint8_t type, uint32_t groupWord)
+ * \brief Send an igmp v2 report or leave message for a group
+ *
+ * \param ctrlId network controller id
+ * \param type igmp message type (IGMP_V2_MEMBERSHIP_REPORT or IGMP_LEAVE_GROUP)
+ * \param groupWord group address (memory order word)
+ * \return bool: true if the packet was sent
+ */
+static bool NetworkSendIgmpMessage(uint8_t ctrlId, uint8_t type, uint32_t groupWord) {
+    uint8_t bufferIgmp[ETH_HEADER_SIZE + IPV4_HEADER_SIZE + IGMP_HEADER_SIZE]; // 42 bytes
+    igmp_header_t *pIgmpHeader = (igmp_header_t *)(bufferIgmp + ETH_HEADER_SIZE + IPV4_HEADER_SIZE);
+    network_msg_info_t msgInfo;
+
+    // Reports go to the group, leaves to the routers
+    memcpy(pIgmpHeader->groupAddr, &groupWord, IP_ADDR_LENGTH);
+    NetworkInitMsgInfo(&msgInfo, (type == IGMP_LEAVE_GROUP) ? NetworkMcastAllRouters : pIgmpHeader->groupAddr, 0, 0, 0);
+    // Fill igmp header
+    pIgmpHeader->type = type;
+    pIgmpHeader->maxRespTime = 0;
+    pIgmpHeader->checksum = 0;
+    pIgmpHeader->checksum = UtilsRotrUint16(UtilsInetChecksum((uint8_t *)pIgmpHeader, IGMP_HEADER_SIZE), 8);
+    msgInfo.HeaderSize += (uint16_t)IGMP_HEADER_SIZE; // We take into account the igmp header
+    return NetworkSendIpPacket(ctrlId, IP_PROT_IGMP, bufferIgmp, msgInfo);
+}
+
+/**
+ * \fn static bool NetworkProcessIgmpPacket(uint8_t ctrlId, uint8_t *pBuffer, uint16_t buffSize)
+ * \brief Process incoming igmp packets, membership queries are answered with a report per queried group
+ *
+ * \param ctrlId network controller id
+ * \param pBuffer pointer to the buffer to process
+ * \param buffSize buffer size
+ * \return bool: true if processed successfully
+ */
+static bool NetworkProcessIgmpPacket(uint8_t ctrlId, uint8_t *pBuffer, uint16_t buffSize) {
+    network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[ctrlId]);
+    ipv4_header_t *pIpHeader = (ipv4_header_t *)(pBuffer + ETH_HEADER_SIZE);
+    igmp_header_t *pIgmpHeader = (igmp_header_t *)(pBuffer + ETH_HEADER_SIZE + IPV4_HEADER_SIZE);
+    uint16_t igmpLength = NetworkIcmpLength(pIpHeader->length);
+    bool sendStatus = true;
+
+    // Drop corrupted or unknown messages
+    if ((igmpLength < IGMP_HEADER_SIZE) || (buffSize < (ETH_HEADER_SIZE + IPV4_HEADER_SIZE + igmpLength)) || (UtilsInetChecksum((uint8_t *)pIgmpHeader, igmpLength) != 0) || (pIgmpHeader->type != IGMP_MEMBERSHIP_QUERY)) {
+        return true;
+    }
+    // Reports are sent at once, the max response time is not used to spread them
+    uint32_t queryWord = NetworkIpWord(pIgmpHeader->groupAddr);
+    for (uint8_t groupIdx = 0; groupIdx < pNetworkCtrl->pDesc->McastGroupNb; groupIdx++) {
+        const mcast_group_t *pGroup = &(pNetworkCtrl->pMcastArray[groupIdx]);
+
+        if ((pGroup->PortCount != 0) && ((queryWord == 0) || (queryWord == pGroup->GroupWord))) {
+            sendStatus &= NetworkSendIgmpMessage(ctrlId, IGMP_V2_MEMBERSHIP_REPORT, pGroup->GroupWord);
+        }
+    }
+    return sendStatus;
+}
+
 /**
  * \fn static uint8_t *NetworkDecodeUdpPacket(uint8_t *pBuffer, uint16_t *pDataSize, uint16_t *pDestPort)
  * \brief Decode an udp packet
@@ -732,23 +1561,28 @@ static uint8_t *NetworkDecodeUdpPacket(uint8_t *pBuffer, uint16_t *pDataSize, ui
 }
 
 /**
- * \fn static bool NetworkStoreSendData(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const uint8_t *pIpDest)
+ * \fn static bool NetworkStoreSendData(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const uint8_t *pIpDest, uint16_t destPort)
  * \brief Store data into the send fifo
  *
  * \param portId network port id
  * \param pBuffer pointer to the send buffer
  * \param buffSize send buffer size
  * \param pIpDest recipient ip address (optional)
+ * \param destPort recipient port (0: port distant port)
  * \return bool: true if stored successfully
  */
-static bool NetworkStoreSendData(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const uint8_t *pIpDest) {
+static bool NetworkStoreSendData(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const uint8_t *pIpDest, uint16_t destPort) {
+    // Virtual com port: latency bound starts with the first gathered byte
+    if ((NetworkInfo.pPortInfoList[portId].IsVirtualComTx) && (NetworkInfo.pPortInfoList[portId].pDesc->TxCoalesceSize != 0) && (FifoItemCount(NetworkInfo.pPortInfoList[portId].pFifoTxMsg) == 0)) {
+        NetworkInfo.pPortInfoList[portId].TimerCoalesce = NetworkInfo.pInitDesc->GenInterface.pFnTimerGetTime() + NetworkInfo.pPortInfoList[portId].pDesc->TxCoalesceDelay;
+    }
     // Check if we can store the message descriptor ahead of time
     if ((NetworkInfo.pPortInfoList[portId].IsVirtualComTx) || (FifoFreeSpace(NetworkInfo.pPortInfoList[portId].pFifoTxMsgDesc) > 0)) {
         // Try to store the buffer in the main fifo
         bool sendStatus = FifoWrite(NetworkInfo.pPortInfoList[portId].pFifoTxMsg, pBuffer, buffSize);
         if (sendStatus && !NetworkInfo.pPortInfoList[portId].IsVirtualComTx) {
             // Try to store the descriptor
-            network_msg_desc_t msgDesc = {.MsgSize = buffSize, .IpAddr = {0,0,0,0}};
+            network_msg_desc_t msgDesc = {.MsgSize = buffSize, .PortNb = destPort, .IpAddr = {0,0,0,0}};
             // Check if dest ip defined
             if (pIpDest != NULL) {
                 memcpy(msgDesc.IpAddr, pIpDest, IP_ADDR_LENGTH);
@@ -761,41 +1595,478 @@ static bool NetworkStoreSendData(uint8_t portId, const uint8_t *pBuffer, uint16_
 }
 
 /**
- * \fn static bool NetworkStoreIncMsg(const uint8_t *pBuffer, uint16_t buffSize, uint16_t destPort, uint8_t protocol, uint8_t *pIpSrc)
- * \brief Store an incoming message
+ * \fn static bool NetworkReadTxData(uint8_t portId, uint8_t *pPayload, uint16_t payloadOffset, uint32_t fifoOffset, uint16_t size, uint32_t *pSum)
+ * \brief Copy stored data into a datagram payload, adding it to a checksum in the same pass if needed (data is not consumed)
+ *
+ * \param portId network port id
+ * \param pPayload pointer to the datagram payload
+ * \param payloadOffset data position in the payload
+ * \param fifoOffset data position in the port transmit fifo
+ * \param size data size
+ * \param pSum pointer to the payload sum to update (optional)
+ * \return bool: true if data was read
+ */
+static bool NetworkReadTxData(uint8_t portId, uint8_t *pPayload, uint16_t payloadOffset, uint32_t fifoOffset, uint16_t size, uint32_t *pSum) {
+    fifo_span_t spans[2];
+
+    if (!FifoGetReadSpans(NetworkInfo.pPortInfoList[portId].pFifoTxMsg, fifoOffset, size, spans)) {
+        return false;
+    }
+    for (uint8_t spanIdx = 0; spanIdx < 2; spanIdx++) {
+        if (pSum != NULL) {
+            *pSum = NetworkCopyAndSum(pPayload + payloadOffset, spans[spanIdx].pData, spans[spanIdx].ItemNb, *pSum, (payloadOffset & 1) != 0);
+        } else {
+            memcpy(pPayload + payloadOffset, spans[spanIdx].pData, spans[spanIdx].ItemNb);
+        }
+        payloadOffset += (uint16_t)spans[spanIdx].ItemNb;
+    }
+    return true;
+}
+
+/**
+ * \fn static bool NetworkStorePortMsg(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const uint8_t *pIpSrc, uint16_t srcPort, const uint32_t *pHeaderSum)
+ * \brief Store an incoming message in a network port receive fifo
+ *
+ * \param portId network port id
+ * \param pBuffer pointer to the message data
+ * \param buffSize buffer size
+ * \param pIpSrc pointer to the sender ip address
+ * \param srcPort sender port
+ * \param pHeaderSum pointer to the udp headers sum, received checksum included (NULL: no checksum to verify)
+ * \return bool: true if stored successfully, handled by the port rx callback or dropped for a bad checksum
+ */
+static bool NetworkStorePortMsg(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const uint8_t *pIpSrc, uint16_t srcPort, const uint32_t *pHeaderSum) {
+    // Rx callback sees the message in place, it is not stored if the callback takes it
+    if ((NetworkInfo.pPortInfoList[portId].pDesc->pFnRxCallback != NULL) && !NetworkInfo.pPortInfoList[portId].IsVirtualComRx) {
+        network_endpoint_t src = {.PortNb = srcPort};
+
+        if ((pHeaderSum != NULL) && ((NetworkInfo.pPortInfoList[portId].pDesc->Options & NETWORK_PORT_OPT_UDP_CKSUM) != 0)) {
+            // Corrupted message, drop it
+            if (UtilsInetFold(NetworkSumBytes(pBuffer, buffSize, *pHeaderSum, false)) != 0xFFFF) {
+                return true;
+            }
+            pHeaderSum = NULL;
+        }
+        memcpy(src.IpAddr, pIpSrc, IP_ADDR_LENGTH);
+        // The callback can also close the port, nothing is left to store then
+        if (NetworkInfo.pPortInfoList[portId].pDesc->pFnRxCallback(portId, pBuffer, buffSize, &src) || !NetworkPortValid(portId)) {
+            return true;
+        }
+    }
+    // Check if we can store the message descriptor ahead of time
+    if ((NetworkInfo.pPortInfoList[portId].IsVirtualComRx) || (FifoFreeSpace(NetworkInfo.pPortInfoList[portId].pFifoRxMsgDesc) > 0)) {
+        bool storeStatus;
+        if ((pHeaderSum != NULL) && ((NetworkInfo.pPortInfoList[portId].pDesc->Options & NETWORK_PORT_OPT_UDP_CKSUM) != 0)) {
+            // Verify the checksum while copying the buffer in the main fifo
+            fifo_span_t spans[2];
+            if (!FifoGetWriteSpans(NetworkInfo.pPortInfoList[portId].pFifoRxMsg, buffSize, spans)) {
+                return false;
+            }
+            uint32_t sum = NetworkCopyAndSum(spans[0].pData, pBuffer, spans[0].ItemNb, *pHeaderSum, false);
+            sum = NetworkCopyAndSum(spans[1].pData, pBuffer + spans[0].ItemNb, spans[1].ItemNb, sum, (spans[0].ItemNb & 1) != 0);
+            // Corrupted message, drop it
+            if (UtilsInetFold(sum) != 0xFFFF) {
+                return true;
+            }
+            storeStatus = FifoCommit(NetworkInfo.pPortInfoList[portId].pFifoRxMsg, buffSize);
+        } else {
+            // Try to store the buffer in the main fifo
+            storeStatus = FifoWrite(NetworkInfo.pPortInfoList[portId].pFifoRxMsg, pBuffer, buffSize);
+        }
+        if (storeStatus && !NetworkInfo.pPortInfoList[portId].IsVirtualComRx) {
+            // Try to store the descriptor
+            network_msg_desc_t msgDesc = {.MsgSize = buffSize, .PortNb = srcPort, .IpAddr = {0,0,0,0}};
+            memcpy(msgDesc.IpAddr, pIpSrc, IP_ADDR_LENGTH);
+            storeStatus &= FifoWrite(NetworkInfo.pPortInfoList[portId].pFifoRxMsgDesc, &msgDesc, 1);
+        }
+        return storeStatus;
+    }
+    return false;
+}
+
+/**
+ * \fn static bool NetworkStoreAggregatedMsg(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const uint8_t *pIpSrc, uint16_t srcPort, const uint32_t *pHeaderSum)
+ * \brief Split an aggregated datagram and store each message in a network port receive fifo
+ *
+ * \param portId network port id
+ * \param pBuffer pointer to the datagram data
+ * \param buffSize buffer size
+ * \param pIpSrc pointer to the sender ip address
+ * \param srcPort sender port
+ * \param pHeaderSum pointer to the udp headers sum, received checksum included (NULL: no checksum to verify)
+ * \return bool: true if all messages were stored successfully
+ */
+static bool NetworkStoreAggregatedMsg(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const uint8_t *pIpSrc, uint16_t srcPort, const uint32_t *pHeaderSum) {
+    bool storeStatus = true;
+    uint16_t offset = 0;
+
+    // The checksum covers the whole datagram, verify it before storing any message
+    if ((pHeaderSum != NULL) && ((NetworkInfo.pPortInfoList[portId].pDesc->Options & NETWORK_PORT_OPT_UDP_CKSUM) != 0)) {
+        if (UtilsInetFold(NetworkSumBytes(pBuffer, buffSize, *pHeaderSum, false)) != 0xFFFF) {
+            return true;
+        }
+    }
+
+    while ((offset + NETWORK_AGGREGATE_PREFIX_SIZE) <= buffSize) {
+        uint16_t msgSize = (uint16_t)((pBuffer[offset] << 8) | pBuffer[offset + 1]);
+        offset += NETWORK_AGGREGATE_PREFIX_SIZE;
+        // Malformed datagram, drop the remaining data
+        if (msgSize > (buffSize - offset)) {
+            return false;
+        }
+        storeStatus &= NetworkStorePortMsg(portId, pBuffer + offset, msgSize, pIpSrc, srcPort, NULL);
+        offset += msgSize;
+        // Port closed by its rx callback, drop the remaining messages
+        if (!NetworkPortValid(portId)) {
+            return storeStatus;
+        }
+    }
+    return storeStatus && (offset == buffSize);
+}
+
+/**
+ * \fn static bool NetworkIsPortRecipient(uint8_t portId, uint16_t destPort, uint8_t protocol, const uint8_t *pPortMap)
+ * \brief Indicates if a network port is bound to an incoming message port number and protocol
+ *
+ * \param portId network port id
+ * \param destPort destination port
+ * \param protocol message ip protocol
+ * \param pPortMap group subscribed ports bitmap (NULL if unicast)
+ * \return bool: true if the port is a recipient
+ */
+static bool NetworkIsPortRecipient(uint8_t portId, uint16_t destPort, uint8_t protocol, const uint8_t *pPortMap) {
+    // Skip non-valid, connected (demultiplexed by endpoints) or non-subscribed network ports
+    if (!NetworkPortValid(portId) || NetworkInfo.pPortInfoList[portId].IsConnected || ((pPortMap != NULL) && ((pPortMap[portId / 8] & (1 << (portId % 8))) == 0))) {
+        return false;
+    }
+    // Check port number and protocol
+    return (destPort == NetworkInfo.pPortInfoList[portId].InPortNb) && (protocol == NetworkInfo.pPortInfoList[portId].pDesc->Protocol);
+}
+
+/**
+ * \fn static void NetworkLinkConnPort(uint8_t portId)
+ * \brief Insert a connected port in the hash bucket of its endpoints
+ *
+ * \param portId network port id
+ * \return void
+ */
+static void NetworkLinkConnPort(uint8_t portId) {
+    network_port_info_t *pNetworkPort = &(NetworkInfo.pPortInfoList[portId]);
+    uint8_t bucketIdx = NetworkFlowHash(pNetworkPort->DstIpAddr, pNetworkPort->OutPortNb, pNetworkPort->InPortNb) & (NETWORK_CONN_TABLE_SIZE - 1);
+
+    pNetworkPort->NextConnPortId = NetworkInfo.pConnTable[bucketIdx];
+    NetworkInfo.pConnTable[bucketIdx] = portId;
+}
+
+/**
+ * \fn static void NetworkUnlinkConnPort(uint8_t portId)
+ * \brief Remove a connected port from the hash bucket of its endpoints, to be called before they change
+ *
+ * \param portId network port id
+ * \return void
+ */
+static void NetworkUnlinkConnPort(uint8_t portId) {
+    network_port_info_t *pNetworkPort = &(NetworkInfo.pPortInfoList[portId]);
+
+    if (pNetworkPort->IsConnected) {
+        uint8_t *pLink = &(NetworkInfo.pConnTable[NetworkFlowHash(pNetworkPort->DstIpAddr, pNetworkPort->OutPortNb, pNetworkPort->InPortNb) & (NETWORK_CONN_TABLE_SIZE - 1)]);
+
+        while (*pLink != portId) {
+            pLink = &(NetworkInfo.pPortInfoList[*pLink].NextConnPortId);
+        }
+        *pLink = pNetworkPort->NextConnPortId;
+    }
+}
+
+/**
+ * \fn static uint8_t NetworkGetConnPort(const uint8_t *pIpSrc, uint16_t srcPort, uint16_t destPort, uint8_t protocol)
+ * \brief Lookup for the connected port of an incoming message endpoints
+ *
+ * \param pIpSrc pointer to the sender ip address
+ * \param srcPort sender port
+ * \param destPort destination port
+ * \param protocol message ip protocol
+ * \return uint8_t: connected port id (NETWORK_PORT_NONE if not found)
+ */
+static uint8_t NetworkGetConnPort(const uint8_t *pIpSrc, uint16_t srcPort, uint16_t destPort, uint8_t protocol) {
+    uint32_t srcWord = NetworkIpWord(pIpSrc);
+    uint8_t portId = NetworkInfo.pConnTable[NetworkFlowHash(pIpSrc, srcPort, destPort) & (NETWORK_CONN_TABLE_SIZE - 1)];
+
+    for (; portId != NETWORK_PORT_NONE; portId = NetworkInfo.pPortInfoList[portId].NextConnPortId) {
+        const network_port_info_t *pNetworkPort = &(NetworkInfo.pPortInfoList[portId]);
+
+        if ((pNetworkPort->InPortNb == destPort) && (pNetworkPort->OutPortNb == srcPort) && (NetworkIpWord(pNetworkPort->DstIpAddr) == srcWord) && (pNetworkPort->pDesc->Protocol == protocol)) {
+            break;
+        }
+    }
+    return portId;
+}
+
+/**
+ * \fn static bool NetworkStoreIncMsg(const uint8_t *pBuffer, uint16_t buffSize, uint16_t destPort, uint8_t protocol, uint8_t *pIpSrc, uint16_t srcPort, const uint32_t *pHeaderSum, const uint8_t *pPortMap)
+ * \brief Store an incoming message, recipient ports of a load balancing group share the messages by sender flow
  *
  * \param pBuffer pointer to the message data
  * \param buffSize buffer size
  * \param destPort destination port
  * \param protocol message ip protocol
  * \param pIpSrc pointer to the sender ip address
+ * \param srcPort sender port
+ * \param pPortMap group subscribed ports bitmap, the message goes to these ports only (NULL if unicast)
  * \return bool: true if stored successfully
  */
-static bool NetworkStoreIncMsg(const uint8_t *pBuffer, uint16_t buffSize, uint16_t destPort, uint8_t protocol, uint8_t *pIpSrc) {
+static bool NetworkStoreIncMsg(const uint8_t *pBuffer, uint16_t buffSize, uint16_t destPort, uint8_t protocol, uint8_t *pIpSrc, uint16_t srcPort, const uint32_t *pHeaderSum, const uint8_t *pPortMap) {
     bool storeStatus = true;
+    uint8_t memberNb = 0;
+    uint8_t memberIdx = 0;
+
+    // Connected ports take the datagrams of their remote endpoint, unrelated traffic is dropped before any copy
+    if (pPortMap == NULL) {
+        uint8_t connPortId = NetworkGetConnPort(pIpSrc, srcPort, destPort, protocol);
 
+        if (connPortId != NETWORK_PORT_NONE) {
+            if ((NetworkInfo.pPortInfoList[connPortId].pDesc->Options & NETWORK_PORT_OPT_AGGREGATE) != 0) {
+                return NetworkStoreAggregatedMsg(connPortId, pBuffer, buffSize, pIpSrc, srcPort, pHeaderSum);
+            }
+            return NetworkStorePortMsg(connPortId, pBuffer, buffSize, pIpSrc, srcPort, pHeaderSum);
+        }
+    }
+    // Count load balancing group members
+    for (uint8_t portId = 0; portId < NetworkInfo.pInitDesc->PortNb; portId++) {
+        if (NetworkIsPortRecipient(portId, destPort, protocol, pPortMap) && ((NetworkInfo.pPortInfoList[portId].pDesc->Options & NETWORK_PORT_OPT_REUSEPORT) != 0)) {
+            memberNb++;
+        }
+    }
+    // A sender flow always goes to the same member
+    uint8_t selectedIdx = (memberNb > 0) ? (uint8_t)(NetworkFlowHash(pIpSrc, srcPort, destPort) % memberNb) : 0;
     // Parse all instantiated network ports
     for (uint8_t portId = 0; portId < NetworkInfo.pInitDesc->PortNb; portId++) {
-        // Check port number and protocol
-        if ((destPort == NetworkInfo.pPortInfoList[portId].InPortNb) && (protocol == NetworkInfo.pPortInfoList[portId].pDesc->Protocol)) {
-            // Check if we can store the message descriptor ahead of time
-            if ((NetworkInfo.pPortInfoList[portId].IsVirtualComRx) || (FifoFreeSpace(NetworkInfo.pPortInfoList[portId].pFifoRxMsgDesc) > 0)) {
-                // Try to store the buffer in the main fifo
-                storeStatus = FifoWrite(NetworkInfo.pPortInfoList[portId].pFifoRxMsg, pBuffer, buffSize);
-                if (storeStatus && !NetworkInfo.pPortInfoList[portId].IsVirtualComRx) {
-                    // Try to store the descriptor
-                    network_msg_desc_t msgDesc = {.MsgSize = buffSize, .IpAddr = {0,0,0,0}};
-                    memcpy(msgDesc.IpAddr, pIpSrc, IP_ADDR_LENGTH);
-                    storeStatus &= FifoWrite(NetworkInfo.pPortInfoList[portId].pFifoRxMsgDesc, &msgDesc, 1);
+        if (NetworkIsPortRecipient(portId, destPort, protocol, pPortMap)) {
+            // Skip the other group members
+            if ((NetworkInfo.pPortInfoList[portId].pDesc->Options & NETWORK_PORT_OPT_REUSEPORT) != 0) {
+                if (memberIdx++ != selectedIdx) {
+                    continue;
                 }
+            }
+            if ((NetworkInfo.pPortInfoList[portId].pDesc->Options & NETWORK_PORT_OPT_AGGREGATE) != 0) {
+                storeStatus = NetworkStoreAggregatedMsg(portId, pBuffer, buffSize, pIpSrc, srcPort, pHeaderSum);
             } else {
-                storeStatus = false;
+                storeStatus = NetworkStorePortMsg(portId, pBuffer, buffSize, pIpSrc, srcPort, pHeaderSum);
             }
         }
     }
     return storeStatus;
 }
 
+/**
+ * \fn static uint16_t NetworkAggregateMsg(uint8_t portId, const network_msg_desc_t *pFirstDesc, const uint8_t *pDestIp, uint16_t *pMsgNb, uint16_t *pMsgSize)
+ * \brief Gather the stored messages that can be packed with the first one in an aggregated datagram
+ *
+ * \param portId network port id
+ * \param pFirstDesc pointer to the first message descriptor
+ * \param pDestIp pointer to the recipient ip address
+ * \param pMsgNb pointer to contain the number of gathered messages
+ * \param pMsgSize pointer to contain the gathered messages data size (without prefixes)
+ * \return uint16_t: aggregated datagram data size
+ */
+static uint16_t NetworkAggregateMsg(uint8_t portId, const network_msg_desc_t *pFirstDesc, const uint8_t *pDestIp, uint16_t *pMsgNb, uint16_t *pMsgSize) {
+    uint16_t dataSize = NETWORK_AGGREGATE_PREFIX_SIZE + pFirstDesc->MsgSize;
+    uint16_t maxDataSize = NetworkPortMaxDataSize(portId);
+    uint8_t msgDestIp[IP_ADDR_LENGTH];
+    network_msg_desc_t msgDesc;
+
+    *pMsgNb = 1;
+    *pMsgSize = pFirstDesc->MsgSize;
+    // Gather following messages while they share the recipient and fit in the datagram
+    while (FifoPeek(NetworkInfo.pPortInfoList[portId].pFifoTxMsgDesc, &msgDesc, *pMsgNb, 1)) {
+        NetworkGetMsgDestIp(portId, &msgDesc, msgDestIp);
+        if ((memcmp(msgDestIp, pDestIp, IP_ADDR_LENGTH) != 0) || (msgDesc.PortNb != pFirstDesc->PortNb) || ((dataSize + NETWORK_AGGREGATE_PREFIX_SIZE + msgDesc.MsgSize) > maxDataSize)) {
+            break;
+        }
+        dataSize += NETWORK_AGGREGATE_PREFIX_SIZE + msgDesc.MsgSize;
+        *pMsgSize += msgDesc.MsgSize;
+        (*pMsgNb)++;
+    }
+    return dataSize;
+}
+
+/**
+ * \fn static bool NetworkReadAggregatedMsg(uint8_t portId, uint8_t *pData, uint16_t msgNb, uint32_t *pSum)
+ * \brief Read gathered messages with their length prefix (messages are not consumed)
+ *
+ * \param portId network port id
+ * \param pData pointer to the datagram data
+ * \param msgNb number of messages to read
+ * \param pSum pointer to the datagram data sum to update (optional)
+ * \return bool: true if messages were read
+ */
+static bool NetworkReadAggregatedMsg(uint8_t portId, uint8_t *pData, uint16_t msgNb, uint32_t *pSum) {
+    network_port_info_t *pNetworkPort = &(NetworkInfo.pPortInfoList[portId]);
+    uint32_t dataOffset = 0;
+    uint16_t payloadOffset = 0;
+    network_msg_desc_t msgDesc;
+
+    for (uint16_t msgIdx = 0; msgIdx < msgNb; msgIdx++) {
+        if (!FifoPeek(pNetworkPort->pFifoTxMsgDesc, &msgDesc, msgIdx, 1)) {
+            return false;
+        }
+        pData[payloadOffset] = (uint8_t)(msgDesc.MsgSize >> 8);
+        pData[payloadOffset + 1] = (uint8_t)(msgDesc.MsgSize & 0xFF);
+        if (pSum != NULL) {
+            *pSum = NetworkSumBytes(pData + payloadOffset, NETWORK_AGGREGATE_PREFIX_SIZE, *pSum, (payloadOffset & 1) != 0);
+        }
+        payloadOffset += NETWORK_AGGREGATE_PREFIX_SIZE;
+        if (!NetworkReadTxData(portId, pData, payloadOffset, dataOffset, msgDesc.MsgSize, pSum)) {
+            return false;
+        }
+        payloadOffset += msgDesc.MsgSize;
+        dataOffset += msgDesc.MsgSize;
+    }
+    return true;
+}
+
+/**
+ * \fn static bool NetworkSendSegmentedMsg(uint8_t portId, uint8_t *pBuffer, network_msg_info_t msgInfo, uint16_t msgSize)
+ * \brief Send the remaining data of a large message as max size datagrams
+ *
+ * \param portId network port id
+ * \param pBuffer pointer to the transmit buffer
+ * \param msgInfo message network parameters
+ * \param msgSize remaining message data size
+ * \return bool: true if segments were sent or held back by the shaper
+ */
+static bool NetworkSendSegmentedMsg(uint8_t portId, uint8_t *pBuffer, network_msg_info_t msgInfo, uint16_t msgSize) {
+    network_port_info_t *pNetworkPort = &(NetworkInfo.pPortInfoList[portId]);
+    uint8_t ctrlId = pNetworkPort->pDesc->NetworkCtrlId;
+    uint16_t maxDataSize = NetworkInfo.pCtrlInfoList[ctrlId].MaxDataSize;
+    uint8_t capabilities = NetworkInfo.pCtrlInfoList[ctrlId].pDesc->ComInterface.Capabilities;
+    bool isHeaderBuilt = false;
+
+    // The mac segments the remaining data itself, the headers describe the first segment
+    if (((capabilities & NETWORK_CAP_TX_SEGMENT) != 0) && !msgInfo.HasUdpChecksum) {
+        uint16_t segNb = (uint16_t)((msgSize + maxDataSize - 1) / maxDataSize);
+        fifo_span_t spans[2];
+
+        if (!NetworkShaperAllow(portId, (uint32_t)NETWORK_HEADER_SIZE * segNb + msgSize)) {
+            return true;
+        }
+        // Critical error, mismatched or corrupted fifo
+        if (!FifoGetReadSpans(pNetworkPort->pFifoTxMsg, 0, msgSize, spans)) {
+            return false;
+        }
+        msgInfo.DataSize = (msgSize < maxDataSize) ? msgSize : maxDataSize;
+        msgInfo.PayloadSize = msgInfo.DataSize;
+        msgInfo.pDataSpans = spans;
+        if (!NetworkSendUdpPacket(ctrlId, pBuffer, msgInfo)) {
+            return false;
+        }
+        FifoConsume(pNetworkPort->pFifoTxMsg, msgSize);
+        msgSize = 0;
+    }
+    while (msgSize > 0) {
+        uint16_t segSize = (msgSize < maxDataSize) ? msgSize : maxDataSize;
+        bool sendStatus;
+
+        // Hold the remaining segments if the port exceeds its rate limit
+        if (!NetworkShaperAllow(portId, (uint32_t)NETWORK_HEADER_SIZE + segSize)) {
+            return true;
+        }
+        // Critical error, mismatched or corrupted fifo
+        msgInfo.DataSum = 0;
+        if (!NetworkReadTxData(portId, pBuffer + NETWORK_HEADER_SIZE, 0, 0, segSize, msgInfo.HasUdpChecksum ? &msgInfo.DataSum : NULL)) {
+            return false;
+        }
+        // Headers are built once, following segments only update the lengths and udp checksum
+        msgInfo.DataSize = segSize;
+        msgInfo.PayloadSize = segSize;
+        if (!isHeaderBuilt) {
+            sendStatus = NetworkSendUdpPacket(ctrlId, pBuffer, msgInfo);
+            isHeaderBuilt = true;
+        } else {
+            sendStatus = NetworkSendUdpSegment(ctrlId, pBuffer, msgInfo);
+        }
+        if (!sendStatus) {
+            return false;
+        }
+        FifoConsume(pNetworkPort->pFifoTxMsg, segSize);
+        pNetworkPort->TxMsgOffset += segSize;
+        msgSize -= segSize;
+    }
+    // Whole message sent, release its descriptor
+    FifoConsume(pNetworkPort->pFifoTxMsgDesc, 1);
+    pNetworkPort->TxMsgOffset = 0;
+    return true;
+}
+
+/**
+ * \fn static bool NetworkSendFragmentedMsg(uint8_t portId, uint8_t *pBuffer, network_msg_info_t msgInfo, uint16_t msgSize)
+ * \brief Send the remaining fragments of a large udp datagram, read straight from the port fifo
+ *
+ * \param portId network port id
+ * \param pBuffer pointer to the transmit buffer
+ * \param msgInfo message network parameters
+ * \param msgSize remaining message data size
+ * \return bool: true if fragments were sent or held back by the shaper
+ */
+static bool NetworkSendFragmentedMsg(uint8_t portId, uint8_t *pBuffer, network_msg_info_t msgInfo, uint16_t msgSize) {
+    network_port_info_t *pNetworkPort = &(NetworkInfo.pPortInfoList[portId]);
+    uint8_t ctrlId = pNetworkPort->pDesc->NetworkCtrlId;
+
+    // New datagram, take the next identification
+    if (pNetworkPort->TxMsgOffset == 0) {
+        pNetworkPort->TxFragId = NetworkInfo.pCtrlInfoList[ctrlId].IpIdentification++;
+    }
+    msgInfo.PayloadSize = pNetworkPort->TxMsgOffset + msgSize;
+    msgInfo.Identification = pNetworkPort->TxFragId;
+    while (msgSize > 0) {
+        bool isFirst = (pNetworkPort->TxMsgOffset == 0);
+        // The first fragment carries the udp header, all but the last are multiples of 8 bytes
+        uint16_t fragSize = NetworkInfo.pCtrlInfoList[ctrlId].FragDataSize - (isFirst ? (uint16_t)UDP_HEADER_SIZE : 0);
+        uint16_t fragOffset = isFirst ? 0 : (uint16_t)((UDP_HEADER_SIZE + pNetworkPort->TxMsgOffset) / 8);
+        bool sendStatus;
+
+        fragSize = (msgSize < fragSize) ? msgSize : fragSize;
+        msgInfo.FragmentField = fragOffset | ((msgSize > fragSize) ? IPV4_FLAG_MF : 0);
+        msgInfo.DataSize = fragSize;
+        // Hold the remaining fragments if the port exceeds its rate limit
+        if (!NetworkShaperAllow(portId, (uint32_t)(isFirst ? NETWORK_HEADER_SIZE : (ETH_HEADER_SIZE + IPV4_HEADER_SIZE)) + fragSize)) {
+            return true;
+        }
+        if (isFirst) {
+            // The udp checksum covers the whole datagram, sum it before the first fragment
+            if (msgInfo.HasUdpChecksum) {
+                fifo_span_t spans[2];
+                if (!FifoGetReadSpans(pNetworkPort->pFifoTxMsg, 0, msgSize, spans)) {
+                    return false;
+                }
+                msgInfo.DataSum = NetworkSumBytes(spans[0].pData, spans[0].ItemNb, 0, false);
+                msgInfo.DataSum = NetworkSumBytes(spans[1].pData, spans[1].ItemNb, msgInfo.DataSum, (spans[0].ItemNb & 1) != 0);
+            }
+            // Critical error, mismatched or corrupted fifo
+            if (!NetworkReadTxData(portId, pBuffer + NETWORK_HEADER_SIZE, 0, 0, fragSize, NULL)) {
+                return false;
+            }
+            sendStatus = NetworkSendUdpPacket(ctrlId, pBuffer, msgInfo);
+        } else {
+            if (!NetworkReadTxData(portId, pBuffer + ETH_HEADER_SIZE + IPV4_HEADER_SIZE, 0, 0, fragSize, NULL)) {
+                return false;
+            }
+            msgInfo.HeaderSize = 0;
+            sendStatus = NetworkSendIpPacket(ctrlId, IP_PROT_UDP, pBuffer, msgInfo);
+        }
+        if (!sendStatus) {
+            return false;
+        }
+        FifoConsume(pNetworkPort->pFifoTxMsg, fragSize);
+        pNetworkPort->TxMsgOffset += fragSize;
+        msgSize -= fragSize;
+    }
+    // Whole datagram sent, release its descriptor
+    FifoConsume(pNetworkPort->pFifoTxMsgDesc, 1);
+    pNetworkPort->TxMsgOffset = 0;
+    return true;
+}
+
 /**
  * \fn static bool NetworkProcessSendMsg(uint8_t portId, uint8_t *pBuffer)
  * \brief Process and send stored messages or request arp if needed
@@ -806,19 +2077,38 @@ static bool NetworkStoreIncMsg(const uint8_t *pBuffer, uint16_t buffSize, uint16
  */
 static bool NetworkProcessSendMsg(uint8_t portId, uint8_t *pBuffer) {
     uint8_t destIp[IP_ADDR_LENGTH] = {0,0,0,0};
+    uint16_t destPort = NetworkInfo.pPortInfoList[portId].OutPortNb;
+    bool isAggregated = false;
+    bool isSegmented = false;
+    bool isFragmented = false;
+
+    uint16_t maxDataSize = NetworkPortMaxDataSize(portId);
 
     // Get message info
-    uint16_t msgSize = 0;
+    uint16_t msgSize = 0; // Data amount to consume
+    uint16_t msgNb = 1; // Descriptor amount to consume
+    uint16_t dataSize = 0; // Datagram data size
     if (!NetworkInfo.pPortInfoList[portId].IsVirtualComTx) {
         // Attempt to read message descriptor
         network_msg_desc_t msgDesc;
         if (FifoRead(NetworkInfo.pPortInfoList[portId].pFifoTxMsgDesc, &msgDesc, 1, false)) {
             msgSize = msgDesc.MsgSize;
-            // Send to descriptor dest ip address if valid
-            if (memcmp(destIp, msgDesc.IpAddr, IP_ADDR_LENGTH) != 0) {
-                memcpy(destIp, msgDesc.IpAddr, IP_ADDR_LENGTH);
-            } else { // Send to default dest ip address otherwise
-                memcpy(destIp, NetworkInfo.pPortInfoList[portId].DstIpAddr, IP_ADDR_LENGTH);
+            NetworkGetMsgDestIp(portId, &msgDesc, destIp);
+            if (msgDesc.PortNb != 0) {
+                destPort = msgDesc.PortNb;
+            }
+            // Fragment or split large messages, resuming after the part already sent
+            if (((NetworkInfo.pPortInfoList[portId].pDesc->Options & NETWORK_PORT_OPT_FRAGMENT) != 0) && (msgSize > maxDataSize)) {
+                isFragmented = true;
+                msgSize -= NetworkInfo.pPortInfoList[portId].TxMsgOffset;
+            } else if (((NetworkInfo.pPortInfoList[portId].pDesc->Options & NETWORK_PORT_OPT_SEGMENT) != 0) && (msgSize > maxDataSize)) {
+                isSegmented = true;
+                msgSize -= NetworkInfo.pPortInfoList[portId].TxMsgOffset;
+                dataSize = (msgSize < maxDataSize) ? msgSize : maxDataSize;
+            // Pack following messages for the same recipient
+            } else if ((NetworkInfo.pPortInfoList[portId].pDesc->Options & NETWORK_PORT_OPT_AGGREGATE) != 0) {
+                isAggregated = true;
+                dataSize = NetworkAggregateMsg(portId, &msgDesc, destIp, &msgNb, &msgSize);
             }
         } else {
             return false;
@@ -827,31 +2117,74 @@ static bool NetworkProcessSendMsg(uint8_t portId, uint8_t *pBuffer) {
         // Virtual com port: Get as much data as possible and send to default dest ip address
         msgSize = (uint16_t)FifoItemCount(NetworkInfo.pPortInfoList[portId].pFifoTxMsg);
         memcpy(destIp, NetworkInfo.pPortInfoList[portId].DstIpAddr, IP_ADDR_LENGTH);
+        // Gather data until the coalesce size or the latency bound is reached
+        uint16_t coalesceSize = NetworkInfo.pPortInfoList[portId].pDesc->TxCoalesceSize;
+        if (coalesceSize > maxDataSize) {
+            coalesceSize = maxDataSize;
+        }
+        if ((msgSize < coalesceSize) && !NetworkInfo.pInitDesc->GenInterface.pFnTimerIsPassed(NetworkInfo.pPortInfoList[portId].TimerCoalesce)) {
+            return true;
+        }
     }
     // Message size limitation
-    msgSize = (msgSize < ETHERNET_MAX_DATA_SIZE) ? msgSize : ETHERNET_MAX_DATA_SIZE;
+    if (!isAggregated && !isSegmented && !isFragmented) {
+        msgSize = (msgSize < maxDataSize) ? msgSize : maxDataSize;
+        dataSize = msgSize;
+    }
 
     // Send message or arp
     uint8_t ctrlId = NetworkInfo.pPortInfoList[portId].pDesc->NetworkCtrlId;
     uint32_t *pTimerARP = &(NetworkInfo.pPortInfoList[portId].TimerRequestARP);
     network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[ctrlId]);
 
-    // Send only if dest ip valid for this subnet
-    if (NetworkIsIpValid(destIp, pNetworkCtrl->IpAddr, pNetworkCtrl->SubnetMask)) {
+    uint8_t nextHop[IP_ADDR_LENGTH];
+
+    // Send only if dest ip is reachable, directly or through a gateway
+    if (NetworkGetNextHop(pNetworkCtrl, destIp, nextHop)) {
         // Formatting message info
         network_msg_info_t msgInfo;
-        NetworkInitMsgInfo(&msgInfo, destIp, NetworkInfo.pPortInfoList[portId].InPortNb, NetworkInfo.pPortInfoList[portId].OutPortNb, msgSize);
-        // Check arp status for dest ip
-        arp_entry_t *pArpEntry = NetworkGetArpEntry(ctrlId, (uint8_t *)msgInfo.DstIP);
+        NetworkInitMsgInfo(&msgInfo, destIp, NetworkInfo.pPortInfoList[portId].InPortNb, destPort, dataSize);
+        msgInfo.Dscp = NetworkPrioDscp[NetworkInfo.pPortInfoList[portId].pDesc->Priority];
+        // Udp checksums are left to the mac if it can, fragmented datagrams excepted
+        uint8_t capabilities = pNetworkCtrl->pDesc->ComInterface.Capabilities;
+        msgInfo.HasUdpChecksum = ((NetworkInfo.pPortInfoList[portId].pDesc->Options & NETWORK_PORT_OPT_UDP_CKSUM) != 0) && (isFragmented || ((capabilities & NETWORK_CAP_TX_UDP_CKSUM) == 0));
+        // Check arp status for the next hop
+        arp_entry_t *pArpEntry = NetworkGetArpEntry(ctrlId, nextHop);
         // Message is broadcast or arp valid, we can send the message
-        if (NetworkIsIpBroadcast(msgInfo.DstIP, pNetworkCtrl->IpAddr, pNetworkCtrl->SubnetMask) || ((pArpEntry != NULL) && pArpEntry->Status.IsValid)) {
+        if (NetworkIsIpBroadcast(msgInfo.DstIP, pNetworkCtrl) || NetworkIsIpMulticast(msgInfo.DstIP) || ((pArpEntry != NULL) && pArpEntry->Status.IsValid)) {
+            if (isSegmented) {
+                return NetworkSendSegmentedMsg(portId, pBuffer, msgInfo, msgSize);
+            }
+            if (isFragmented) {
+                return NetworkSendFragmentedMsg(portId, pBuffer, msgInfo, msgSize);
+            }
+            // Hold the message if the port exceeds its rate limit
+            if (!NetworkShaperAllow(portId, (uint32_t)NETWORK_HEADER_SIZE + dataSize)) {
+                return true;
+            }
             // Attempt to read message data
-            if (FifoRead(NetworkInfo.pPortInfoList[portId].pFifoTxMsg, pBuffer + NETWORK_HEADER_SIZE, msgSize, false)) {
+            bool readStatus;
+            uint32_t *pDataSum = msgInfo.HasUdpChecksum ? &msgInfo.DataSum : NULL;
+            fifo_span_t spans[2];
+            if (!isAggregated && ((capabilities & NETWORK_CAP_SCATTER_GATHER) != 0)) {
+                // Send the data straight from the fifo
+                readStatus = FifoGetReadSpans(NetworkInfo.pPortInfoList[portId].pFifoTxMsg, 0, msgSize, spans);
+                if (readStatus && (pDataSum != NULL)) {
+                    *pDataSum = NetworkSumBytes(spans[0].pData, spans[0].ItemNb, 0, false);
+                    *pDataSum = NetworkSumBytes(spans[1].pData, spans[1].ItemNb, *pDataSum, (spans[0].ItemNb & 1) != 0);
+                }
+                msgInfo.pDataSpans = spans;
+            } else if (isAggregated) {
+                readStatus = NetworkReadAggregatedMsg(portId, pBuffer + NETWORK_HEADER_SIZE, msgNb, pDataSum);
+            } else {
+                readStatus = NetworkReadTxData(portId, pBuffer + NETWORK_HEADER_SIZE, 0, 0, msgSize, pDataSum);
+            }
+            if (readStatus) {
                 // Attempt to send message
                 if (NetworkSendUdpPacket(ctrlId, pBuffer, msgInfo)) {
                     FifoConsume(NetworkInfo.pPortInfoList[portId].pFifoTxMsg, msgSize);
                     if (!NetworkInfo.pPortInfoList[portId].IsVirtualComTx) {
-                        FifoConsume(NetworkInfo.pPortInfoList[portId].pFifoTxMsgDesc, 1);
+                        FifoConsume(NetworkInfo.pPortInfoList[portId].pFifoTxMsgDesc, msgNb);
                     }
                 } else {
                     return false;
@@ -860,31 +2193,211 @@ static bool NetworkProcessSendMsg(uint8_t portId, uint8_t *pBuffer) {
                 // Critical error, mismatched or corrupted fifo
                 return false;
             }
-        // Arp doesn't exist or invalid, send a request every so often (to avoid arp saturation)
-        } else if ((pArpEntry == NULL) || ((!pArpEntry->Status.IsValid) && (NetworkInfo.pInitDesc->GenInterface.pFnTimerIsPassed(*pTimerARP)))) {
-            // Send a group of ARP requests
-            if (NetworkInfo.pPortInfoList[portId].CounterARP < NETWORK_ARP_REQ_GROUP_NB) {
-                NetworkInfo.pPortInfoList[portId].CounterARP++;
-                *pTimerARP = NetworkInfo.pInitDesc->GenInterface.pFnTimerGetTime() + NETWORK_ARP_REQUEST_COOLDOWN;
-            } else {
-                NetworkInfo.pPortInfoList[portId].CounterARP = 0;
-                // No ARP answer, we drop the packet
-                FifoConsume(NetworkInfo.pPortInfoList[portId].pFifoTxMsg, msgSize);
-                if (!NetworkInfo.pPortInfoList[portId].IsVirtualComTx) {
-                    FifoConsume(NetworkInfo.pPortInfoList[portId].pFifoTxMsgDesc, 1);
+        // Arp doesn't exist or invalid, send a request every so often (to avoid arp saturation)
+        } else if ((pArpEntry == NULL) || ((!pArpEntry->Status.IsValid) && (NetworkInfo.pInitDesc->GenInterface.pFnTimerIsPassed(*pTimerARP)))) {
+            // Send a group of ARP requests
+            if (NetworkInfo.pPortInfoList[portId].CounterARP < NETWORK_ARP_REQ_GROUP_NB) {
+                NetworkInfo.pPortInfoList[portId].CounterARP++;
+                *pTimerARP = NetworkInfo.pInitDesc->GenInterface.pFnTimerGetTime() + NETWORK_ARP_REQUEST_COOLDOWN;
+            } else {
+                NetworkInfo.pPortInfoList[portId].CounterARP = 0;
+                // No ARP answer, we drop the packet
+                FifoConsume(NetworkInfo.pPortInfoList[portId].pFifoTxMsg, msgSize);
+                if (!NetworkInfo.pPortInfoList[portId].IsVirtualComTx) {
+                    FifoConsume(NetworkInfo.pPortInfoList[portId].pFifoTxMsgDesc, msgNb);
+                }
+                NetworkInfo.pPortInfoList[portId].TxMsgOffset = 0;
+            }
+            // Request arp
+            NetworkRequestArp(ctrlId, nextHop);
+        }
+    } else { // if ip invalid, trash the message
+        FifoConsume(NetworkInfo.pPortInfoList[portId].pFifoTxMsg, msgSize);
+        if (!NetworkInfo.pPortInfoList[portId].IsVirtualComTx) {
+            FifoConsume(NetworkInfo.pPortInfoList[portId].pFifoTxMsgDesc, msgNb);
+        }
+        NetworkInfo.pPortInfoList[portId].TxMsgOffset = 0;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * \fn static ip_reasm_ctx_t *NetworkGetReasmContext(uint8_t ctrlId, const ipv4_header_t *pIpHeader)
+ * \brief Returns the reassembly context of a fragment datagram, a new one if needed (stale contexts are evicted)
+ *
+ * \param ctrlId network controller id
+ * \param pIpHeader pointer to the fragment ip header
+ * \return ip_reasm_ctx_t *: pointer to the reassembly context, NULL if none available
+ */
+static ip_reasm_ctx_t *NetworkGetReasmContext(uint8_t ctrlId, const ipv4_header_t *pIpHeader) {
+    network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[ctrlId]);
+    uint16_t identification = SWAP16(pIpHeader->identification);
+    ip_reasm_ctx_t *pFreeCtx = NULL;
+
+    for (uint8_t ctxIdx = 0; ctxIdx < pNetworkCtrl->pDesc->ReasmContextNb; ctxIdx++) {
+        ip_reasm_ctx_t *pCtx = &(pNetworkCtrl->pReasmArray[ctxIdx]);
+
+        // Evict datagrams missing fragments for too long
+        if (pCtx->IsUsed && NetworkInfo.pInitDesc->GenInterface.pFnTimerIsPassed(pCtx->Timeout)) {
+            pCtx->IsUsed = false;
+        }
+        if (pCtx->IsUsed) {
+            // Datagram is identified by (src, id, proto)
+            if ((pCtx->Identification == identification) && (pCtx->Protocol == pIpHeader->protocol) && (memcmp(pCtx->SrcIp, pIpHeader->srcIp, IP_ADDR_LENGTH) == 0)) {
+                return pCtx;
+            }
+        } else if (pFreeCtx == NULL) {
+            pFreeCtx = pCtx;
+        }
+    }
+    // New datagram
+    if (pFreeCtx != NULL) {
+        pFreeCtx->IsUsed = true;
+        pFreeCtx->Identification = identification;
+        pFreeCtx->Protocol = pIpHeader->protocol;
+        memcpy(pFreeCtx->SrcIp, pIpHeader->srcIp, IP_ADDR_LENGTH);
+        pFreeCtx->TotalSize = 0;
+        pFreeCtx->EndOffset = 0;
+        pFreeCtx->BlockNb = 0;
+        memset(pFreeCtx->pHoleMap, 0, NETWORK_REASM_MAP_SIZE(pNetworkCtrl->pDesc->ReasmMaxSize));
+        pFreeCtx->Timeout = NetworkInfo.pInitDesc->GenInterface.pFnTimerGetTime() + NETWORK_REASM_TIMEOUT;
+    }
+    return pFreeCtx;
+}
+
+/**
+ * \fn static bool NetworkProcessIpFragment(uint8_t ctrlId, uint8_t *pBuffer, uint16_t buffSize)
+ * \brief Store an incoming ip fragment and process its datagram once complete
+ *
+ * \param ctrlId network controller id
+ * \param pBuffer pointer to the buffer to process
+ * \param buffSize buffer size
+ * \return bool: true if processed successfully
+ */
+static bool NetworkProcessIpFragment(uint8_t ctrlId, uint8_t *pBuffer, uint16_t buffSize) {
+    network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[ctrlId]);
+    ipv4_header_t *pIpHeader = (ipv4_header_t *)(pBuffer + ETH_HEADER_SIZE);
+    uint16_t fragField = SWAP16(pIpHeader->fragmentOffsetAndFlags);
+    uint16_t ipLength = SWAP16(pIpHeader->length);
+    uint32_t fragOffset = (uint32_t)(fragField & IPV4_FRAG_OFFSET_MASK) * 8;
+    bool isLast = ((fragField & IPV4_FLAG_MF) == 0);
+
+    // Only udp datagrams are reassembled, oversized icmp echoes could not be answered
+    if ((pNetworkCtrl->pDesc->ReasmContextNb == 0) || (pIpHeader->protocol != IP_PROT_UDP) || (ipLength <= IPV4_HEADER_SIZE)) {
+        return true;
+    }
+    // Drop fragments with header options or a length beyond the received frame
+    if ((pIpHeader->ihl != (IPV4_HEADER_SIZE / 4)) || (((uint32_t)ipLength + ETH_HEADER_SIZE) > buffSize)) {
+        return true;
+    }
+    // Drop malformed fragments, all but the last one are multiples of 8 bytes
+    uint16_t fragSize = ipLength - (uint16_t)IPV4_HEADER_SIZE;
+    uint32_t fragEnd = fragOffset + fragSize;
+    if ((!isLast && ((fragSize % 8) != 0)) || (fragEnd > ((uint32_t)pNetworkCtrl->pDesc->ReasmMaxSize + UDP_HEADER_SIZE))) {
+        return true;
+    }
+    ip_reasm_ctx_t *pCtx = NetworkGetReasmContext(ctrlId, pIpHeader);
+    if (pCtx == NULL) {
+        return true;
+    }
+    // Inconsistent datagram end, drop the datagram
+    if (((pCtx->TotalSize != 0) && (fragEnd > pCtx->TotalSize)) || (isLast && (pCtx->EndOffset > fragEnd))) {
+        pCtx->IsUsed = false;
+        return true;
+    }
+    // Store fragment data and mark its blocks as received
+    memcpy(pCtx->pData + NETWORK_REASM_HEADER_SIZE + fragOffset, pBuffer + NETWORK_REASM_HEADER_SIZE, fragSize);
+    for (uint32_t block = fragOffset / 8; block < ((fragEnd + 7) / 8); block++) {
+        uint8_t blockMask = (uint8_t)(1 << (block % 8));
+        if ((pCtx->pHoleMap[block / 8] & blockMask) == 0) {
+            pCtx->pHoleMap[block / 8] |= blockMask;
+            pCtx->BlockNb++;
+        }
+    }
+    if (fragEnd > pCtx->EndOffset) {
+        pCtx->EndOffset = fragEnd;
+    }
+    if (isLast) {
+        pCtx->TotalSize = (uint16_t)fragEnd;
+    }
+    // First fragment headers become the reassembled packet headers
+    if (fragOffset == 0) {
+        memcpy(pCtx->pData, pBuffer, NETWORK_REASM_HEADER_SIZE);
+    }
+    // Wait for the missing fragments
+    if ((pCtx->TotalSize == 0) || (pCtx->BlockNb < ((pCtx->TotalSize + 7) / 8))) {
+        return true;
+    }
+    // Datagram complete, process it as a regular packet
+    ipv4_header_t *pReasmHeader = (ipv4_header_t *)(pCtx->pData + ETH_HEADER_SIZE);
+    pReasmHeader->length = UtilsRotrUint16((uint16_t)(IPV4_HEADER_SIZE + pCtx->TotalSize), 8);
+    pReasmHeader->fragmentOffsetAndFlags = 0;
+    pCtx->IsUsed = false;
+    return NetworkProcessIpPayload(ctrlId, pCtx->pData, (uint16_t)(NETWORK_REASM_HEADER_SIZE + pCtx->TotalSize), true);
+}
+
+/**
+ * \fn static bool NetworkProcessIpPayload(uint8_t ctrlId, uint8_t *pBuffer, uint16_t buffSize, bool isReassembled)
+ * \brief Process the payload of a complete incoming ip packet
+ *
+ * \param ctrlId: network controller id
+ * \param pBuffer: pointer to the buffer to process
+ * \param buffSize: buffer size
+ * \param isReassembled: true if the packet was rebuilt from fragments
+ * \return bool: true if processed successfully
+ */
+static bool NetworkProcessIpPayload(uint8_t ctrlId, uint8_t *pBuffer, uint16_t buffSize, bool isReassembled) {
+    ipv4_header_t *pIpHeader = (ipv4_header_t *)(pBuffer + ETH_HEADER_SIZE);
+
+    switch (pIpHeader->protocol) {
+        case IP_PROT_ICMP:
+            // Process icmp packet
+            return NetworkProcessIcmpPacket(ctrlId, pBuffer, buffSize);
+        break;
+
+        case IP_PROT_IGMP:
+            // Process igmp packet
+            return NetworkProcessIgmpPacket(ctrlId, pBuffer, buffSize);
+        break;
+
+        case IP_PROT_UDP: {
+            udp_header_t *pUdpHeader = (udp_header_t *)(pBuffer + ETH_HEADER_SIZE + IPV4_HEADER_SIZE);
+            uint16_t udpLength = SWAP16(pUdpHeader->length);
+            // Drop datagrams whose udp length does not fit in the received packet
+            if ((udpLength < UDP_HEADER_SIZE) || (((uint32_t)udpLength + ETH_HEADER_SIZE + IPV4_HEADER_SIZE) > buffSize)) {
+                return true;
+            }
+            // Sum udp headers with the received checksum, a zero checksum means none was computed
+            uint16_t rxChecksum = SWAP16(pUdpHeader->checksum);
+            // Already verified by the mac
+            if (!isReassembled && ((NetworkInfo.pCtrlInfoList[ctrlId].pDesc->ComInterface.Capabilities & NETWORK_CAP_RX_UDP_CKSUM) != 0)) {
+                rxChecksum = 0;
+            }
+            uint32_t headerSum = NetworkUdpHeaderSum(pIpHeader->srcIp, pIpHeader->dstIp, SWAP16(pUdpHeader->srcPort), SWAP16(pUdpHeader->dstPort), udpLength) + rxChecksum;
+            // Decode udp packet (header ports are converted to host order in place)
+            uint16_t msgSize = 0;
+            uint16_t destPort = 0;
+            uint8_t *pMsgData = NetworkDecodeUdpPacket(pBuffer, &msgSize, &destPort);
+            // Group datagrams fan out to the subscribed ports
+            const uint8_t *pPortMap = NULL;
+            if (NetworkIsIpMulticast(pIpHeader->dstIp)) {
+                const mcast_group_t *pGroup = NetworkGetMcastGroup(&(NetworkInfo.pCtrlInfoList[ctrlId]), NetworkIpWord(pIpHeader->dstIp));
+                if (pGroup == NULL) {
+                    return true;
                 }
+                pPortMap = pGroup->pPortMap;
             }
-            // Request arp
-            NetworkRequestArp(ctrlId, (uint8_t *)msgInfo.DstIP);
-        }
-    } else { // if ip invalid, trash the message
-        FifoConsume(NetworkInfo.pPortInfoList[portId].pFifoTxMsg, msgSize);
-        if (!NetworkInfo.pPortInfoList[portId].IsVirtualComTx) {
-            FifoConsume(NetworkInfo.pPortInfoList[portId].pFifoTxMsgDesc, 1);
+            // Store message
+            return NetworkStoreIncMsg(pMsgData, msgSize, destPort, IP_PROT_UDP, pIpHeader->srcIp, pUdpHeader->srcPort, (rxChecksum != 0) ? &headerSum : NULL, pPortMap);
         }
-        return false;
+        break;
+
+        default:
+            // Unknown protocol
+            return true;
+        break;
     }
-    return true;
 }
 
 /**
@@ -900,32 +2413,21 @@ static bool NetworkProcessIpPacket(uint8_t ctrlId, uint8_t *pBuffer, uint16_t bu
     ipv4_header_t *pIpHeader = (ipv4_header_t *)(pBuffer + ETH_HEADER_SIZE);
     ethernet_header_t *pEthHeader = (ethernet_header_t *)(pBuffer);
 
+    // Drop packets with a corrupted header
+    if (((NetworkInfo.pCtrlInfoList[ctrlId].pDesc->ComInterface.Capabilities & NETWORK_CAP_RX_IPV4_CKSUM) == 0) && (NetworkIpChecksum(pIpHeader) != 0)) {
+        return true;
+    }
     // Process only if packet is accepted
     if (NetworkAcceptIncIpPacket(ctrlId, pIpHeader)) {
-        // Update arp table with new data
-        NetworkUpdateArpTable(ctrlId, pIpHeader->srcIp, pEthHeader->srcMac, false);
-        // Process packet
-        switch (pIpHeader->protocol) {
-            case IP_PROT_ICMP:
-                // Process icmp packet
-                return NetworkProcessIcmpPacket(ctrlId, pBuffer, buffSize);
-            break;
-
-            case IP_PROT_UDP: {
-                // Decode udp packet
-                uint16_t msgSize = 0;
-                uint16_t destPort = 0;
-                uint8_t *pMsgData = NetworkDecodeUdpPacket(pBuffer, &msgSize, &destPort);
-                // Store message
-                return NetworkStoreIncMsg(pMsgData, msgSize, destPort, IP_PROT_UDP, pIpHeader->srcIp);
-            }
-            break;
-
-            default:
-                // Unknown protocol
-                return true;
-            break;
+        // Update arp table with new data (on-link senders only, others come through a gateway)
+        if (NetworkIsIpValid(pIpHeader->srcIp, &(NetworkInfo.pCtrlInfoList[ctrlId]))) {
+            NetworkUpdateArpTable(ctrlId, pIpHeader->srcIp, pEthHeader->srcMac, false);
+        }
+        // Fragments are processed once their datagram is complete
+        if ((SWAP16(pIpHeader->fragmentOffsetAndFlags) & (IPV4_FLAG_MF | IPV4_FRAG_OFFSET_MASK)) != 0) {
+            return NetworkProcessIpFragment(ctrlId, pBuffer, buffSize);
         }
+        return NetworkProcessIpPayload(ctrlId, pBuffer, buffSize, false);
     } else {
         return true;
     }
@@ -984,6 +2486,67 @@ static bool NetworkPortValid(uint8_t portId) {
     return ((portId < NetworkInfo.pInitDesc->PortNb) && (NetworkInfo.pPortInfoList[portId].pDesc != NULL));
 }
 
+/**
+ * \fn static uint16_t NetworkGetEphemeralPort(void)
+ * \brief Returns a free local port of the ephemeral range, allocated in turn
+ *
+ * \return uint16_t: local port nb
+ */
+static uint16_t NetworkGetEphemeralPort(void) {
+    // There are more ephemeral ports than network ports, a free one is found in PortNb + 1 tries
+    for (;;) {
+        uint16_t portNb = NetworkInfo.NextEphemeralPort;
+        bool isUsed = false;
+
+        NetworkInfo.NextEphemeralPort = (portNb == NETWORK_EPHEMERAL_PORT_MAX) ? NETWORK_EPHEMERAL_PORT_MIN : portNb + 1;
+        for (uint8_t portId = 0; portId < NetworkInfo.pInitDesc->PortNb; portId++) {
+            isUsed |= NetworkPortValid(portId) && (NetworkInfo.pPortInfoList[portId].InPortNb == portNb);
+        }
+        if (!isUsed) {
+            return portNb;
+        }
+    }
+}
+
+/**
+ * \fn static void *NetworkPortGetFifo(void *pFifo, uint32_t itemNb, uint32_t itemSize)
+ * \brief Returns a flushed port fifo, the previous one is recycled if large enough
+ *
+ * \param pFifo pointer to the previous fifo (NULL if none)
+ * \param itemNb fifo item nb
+ * \param itemSize fifo item size
+ * \return void *: pointer to the fifo
+ */
+static void *NetworkPortGetFifo(void *pFifo, uint32_t itemNb, uint32_t itemSize) {
+    if ((pFifo != NULL) && ((FifoItemCount(pFifo) + FifoFreeSpace(pFifo)) >= itemNb)) {
+        FifoFlush(pFifo);
+        return pFifo;
+    }
+    return FifoCreate(itemNb, itemSize);
+}
+
+/**
+ * \fn static bool NetworkPortFifosFit(uint8_t portId, const network_port_desc_t *pPortDesc)
+ * \brief Indicates if a network port slot has fifos large enough to be recycled for a descriptor
+ *
+ * \param portId network port id
+ * \param pPortDesc pointer to the network port descriptor
+ * \return bool: true if no fifo has to be allocated
+ */
+static bool NetworkPortFifosFit(uint8_t portId, const network_port_desc_t *pPortDesc) {
+    const network_port_info_t *pNetworkPort = &(NetworkInfo.pPortInfoList[portId]);
+    void *fifoList[4] = {pNetworkPort->pFifoRxMsg, pNetworkPort->pFifoTxMsg, pNetworkPort->pFifoRxMsgDesc, pNetworkPort->pFifoTxMsgDesc};
+    uint32_t sizeList[4] = {pPortDesc->RxFifoSize, pPortDesc->TxFifoSize, pPortDesc->RxDescFifoSize, pPortDesc->TxDescFifoSize};
+    bool isFit = true;
+
+    for (uint8_t fifoIdx = 0; fifoIdx < 4; fifoIdx++) {
+        if (sizeList[fifoIdx] != 0) {
+            isFit &= (fifoList[fifoIdx] != NULL) && ((FifoItemCount(fifoList[fifoIdx]) + FifoFreeSpace(fifoList[fifoIdx])) >= sizeList[fifoIdx]);
+        }
+    }
+    return isFit;
+}
+
 /**
  * \fn static bool NetworkCheckGenItfc(const network_gen_itfc_t *pGenItfc)
  * \brief Check the validity of the module descriptor generic interface
@@ -1003,6 +2566,14 @@ static bool NetworkCheckGenItfc(const network_gen_itfc_t *pGenItfc) {
  * \return bool: true if valid
  */
 static bool NetworkCheckComItfc(const network_com_itfc_t *pComItfc) {
+    // Gathered sends need their function, mac segmentation needs gathered sends
+    if ((pComItfc->Capabilities & NETWORK_CAP_SCATTER_GATHER) == 0) {
+        if ((pComItfc->Capabilities & NETWORK_CAP_TX_SEGMENT) != 0) {
+            return false;
+        }
+    } else if (pComItfc->MacCtrlSendMsgSg == NULL) {
+        return false;
+    }
     return ((pComItfc->MacCtrlGetMsg != NULL) && (pComItfc->MacCtrlHasMsg != NULL) && (pComItfc->MacCtrlSendMsg != NULL) && (pComItfc->MacCtrlSetMacAddr != NULL));
 }
 
@@ -1017,8 +2588,15 @@ bool NetworkInit(const network_init_desc_t *pInitDesc) {
         // Info structures memory allocation
         NetworkInfo.pCtrlInfoList = MemAllocCalloc((uint32_t)sizeof(network_ctrl_info_t) * pInitDesc->CtrlNb);
         NetworkInfo.pPortInfoList = MemAllocCalloc((uint32_t)sizeof(network_port_info_t) * pInitDesc->PortNb);
-        // Buffer memory allocation
-        NetworkInfo.pBuffer = MemAllocCalloc(ETHERNET_FRAME_LENTGH_MAX);
+        NetworkInfo.pTxPortOrder = MemAllocCalloc((uint32_t)sizeof(uint8_t) * pInitDesc->PortNb);
+        NetworkSortTxPorts();
+        NetworkInfo.pConnTable = MemAllocMalloc((uint32_t)sizeof(uint8_t) * NETWORK_CONN_TABLE_SIZE);
+        memset(NetworkInfo.pConnTable, NETWORK_PORT_NONE, NETWORK_CONN_TABLE_SIZE);
+        // Buffer is allocated with the controllers, once their frame size is known
+        NetworkInfo.pBuffer = NULL;
+        NetworkInfo.BufferSize = 0;
+        NetworkInfo.NextEphemeralPort = NETWORK_EPHEMERAL_PORT_MIN;
+        NetworkInfo.IsRxPass = false;
         return true;
     } else {
         return false;
@@ -1026,7 +2604,8 @@ bool NetworkInit(const network_init_desc_t *pInitDesc) {
 }
 
 bool NetworkCtrlAdd(uint8_t ctrlId, const network_ctrl_desc_t *pCtrlDesc) {
-    if ((ctrlId < NetworkInfo.pInitDesc->CtrlNb) && (pCtrlDesc != NULL) && NetworkCheckComItfc(&pCtrlDesc->ComInterface)) {
+    if ((ctrlId < NetworkInfo.pInitDesc->CtrlNb) && (pCtrlDesc != NULL) && NetworkCheckComItfc(&pCtrlDesc->ComInterface) && (pCtrlDesc->ReasmMaxSize <= UDP_MAX_DATA_SIZE)
+        && ((pCtrlDesc->Mtu == 0) || ((pCtrlDesc->Mtu >= IPV4_MIN_MTU) && (pCtrlDesc->Mtu <= ETHERNET_JUMBO_PAYLOAD_SIZE)))) {
         network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[ctrlId]);
 
         // Copy desc address
@@ -1035,12 +2614,42 @@ bool NetworkCtrlAdd(uint8_t ctrlId, const network_ctrl_desc_t *pCtrlDesc) {
         pNetworkCtrl->TimerDecayARP  = 0;
         pNetworkCtrl->IcmpReplyDelay = 0;
         pNetworkCtrl->IcmpReplyReceived = false;
+        // Init frame sizes
+        pNetworkCtrl->Mtu = (pCtrlDesc->Mtu != 0) ? pCtrlDesc->Mtu : (uint16_t)ETHERNET_PAYLOAD_SIZE;
+        pNetworkCtrl->MaxDataSize = pNetworkCtrl->Mtu - (uint16_t)(IPV4_HEADER_SIZE + UDP_HEADER_SIZE);
+        pNetworkCtrl->FragDataSize = (pNetworkCtrl->Mtu - (uint16_t)IPV4_HEADER_SIZE) & ~7;
+        // Grow the Tx/Rx buffer to fit the controller frames
+        if (NetworkInfo.BufferSize < (pNetworkCtrl->Mtu + ETH_HEADER_SIZE)) {
+            NetworkInfo.BufferSize = pNetworkCtrl->Mtu + (uint16_t)ETH_HEADER_SIZE;
+            NetworkInfo.pBuffer = MemAllocCalloc(NetworkInfo.BufferSize);
+        }
         // Init arp table
         pNetworkCtrl->pArpArray = MemAllocCalloc((uint32_t)sizeof(arp_entry_t) * pCtrlDesc->ArpEntryNb);
+        // Init ip reassembly contexts
+        if (pCtrlDesc->ReasmContextNb != 0) {
+            pNetworkCtrl->pReasmArray = MemAllocCalloc((uint32_t)sizeof(ip_reasm_ctx_t) * pCtrlDesc->ReasmContextNb);
+            for (uint8_t ctxIdx = 0; ctxIdx < pCtrlDesc->ReasmContextNb; ctxIdx++) {
+                pNetworkCtrl->pReasmArray[ctxIdx].pData = MemAllocMalloc((uint32_t)NETWORK_REASM_HEADER_SIZE + UDP_HEADER_SIZE + pCtrlDesc->ReasmMaxSize);
+                pNetworkCtrl->pReasmArray[ctxIdx].pHoleMap = MemAllocCalloc(NETWORK_REASM_MAP_SIZE(pCtrlDesc->ReasmMaxSize));
+            }
+        }
         // Init controller subnet mask
         memcpy(pNetworkCtrl->SubnetMask, pCtrlDesc->DefaultSubnetMask, IP_ADDR_LENGTH);
-        // Init controller ip address
+        // Init controller ip address and aliases
         memcpy(pNetworkCtrl->IpAddr, pCtrlDesc->DefaultIpAddr, IP_ADDR_LENGTH);
+        pNetworkCtrl->pAddrArray = MemAllocCalloc((uint32_t)sizeof(ip_addr_info_t) * (1 + pCtrlDesc->IpAliasNb));
+        pNetworkCtrl->AddrNb = 1;
+        // Init routing table, room is kept for the default gateway
+        pNetworkCtrl->pRouteArray = MemAllocCalloc((uint32_t)sizeof(ip_route_t) * (1 + pCtrlDesc->RouteNb));
+        pNetworkCtrl->pRouteCache = MemAllocCalloc((uint32_t)sizeof(route_cache_entry_t) * NETWORK_ROUTE_CACHE_SIZE);
+        pNetworkCtrl->RouteCount = 0;
+        // Init multicast group table, each entry has its port bitmap
+        pNetworkCtrl->pMcastArray = MemAllocCalloc((uint32_t)sizeof(mcast_group_t) * pCtrlDesc->McastGroupNb);
+        for (uint8_t groupIdx = 0; groupIdx < pCtrlDesc->McastGroupNb; groupIdx++) {
+            pNetworkCtrl->pMcastArray[groupIdx].pPortMap = MemAllocCalloc((NetworkInfo.pInitDesc->PortNb + 7) / 8);
+        }
+        pNetworkCtrl->McastMacFilter = 0;
+        NetworkUpdateCtrlAddr(pNetworkCtrl);
         // Init controller mac address
         memcpy(pNetworkCtrl->MacAddr, pCtrlDesc->DefaultMacAddr, MAC_ADDR_LENGTH);
         // Send mac address to mac controller
@@ -1052,35 +2661,59 @@ bool NetworkCtrlAdd(uint8_t ctrlId, const network_ctrl_desc_t *pCtrlDesc) {
 }
 
 bool NetworkPortAdd(uint8_t portId, const network_port_desc_t *pPortDesc) {
-    if ((portId < NetworkInfo.pInitDesc->PortNb) && (pPortDesc != NULL)) {
+    if ((portId < NetworkInfo.pInitDesc->PortNb) && (pPortDesc != NULL) && (pPortDesc->Priority < NETWORK_PRIO_NB)) {
         network_port_info_t *pNetworkPort = &(NetworkInfo.pPortInfoList[portId]);
         network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[pPortDesc->NetworkCtrlId]);
 
-        // Add only if default dest ip address valid for the subnet
-        if (NetworkIsIpValid(pPortDesc->DefaultDstIpAddr, pNetworkCtrl->IpAddr, pNetworkCtrl->SubnetMask)) {
+        uint8_t nextHop[IP_ADDR_LENGTH];
+
+        // Add only if default dest ip address is reachable
+        if (NetworkGetNextHop(pNetworkCtrl, pPortDesc->DefaultDstIpAddr, nextHop)) {
+            // A port added again leaves its connection
+            if (NetworkPortValid(portId)) {
+                NetworkUnlinkConnPort(portId);
+            }
+            pNetworkPort->IsConnected = false;
+            pNetworkPort->IsTxBatch = false;
+            // Init default local port nb, before the port is valid again
+            pNetworkPort->InPortNb = (pPortDesc->DefaultInPortNb != 0) ? pPortDesc->DefaultInPortNb : NetworkGetEphemeralPort();
             // Copy desc address
             pNetworkPort->pDesc = pPortDesc;
             // Init internal variables
             pNetworkPort->TimerRequestARP = 0;
+            pNetworkPort->TxMsgOffset = 0;
+            memset(&pNetworkPort->Stats, 0, sizeof(network_port_stats_t));
+            // Init tx shaper with a full bucket
+            pNetworkPort->ShaperTokens = (int32_t)pPortDesc->TxBurstSize * 1000;
+            pNetworkPort->IsShaperHolding = false;
+            if (pPortDesc->TxRateLimit != 0) {
+                pNetworkPort->ShaperTime = NetworkInfo.pInitDesc->GenInterface.pFnTimerGetTime();
+            }
             pNetworkPort->IsVirtualComTx = true;
             pNetworkPort->IsVirtualComRx = true;
             // Init default dest ip address
             memcpy(pNetworkPort->DstIpAddr, pPortDesc->DefaultDstIpAddr, IP_ADDR_LENGTH);
-            // Init default network ports nb
-            pNetworkPort->InPortNb = pPortDesc->DefaultInPortNb;
+            // Init default distant port nb
             pNetworkPort->OutPortNb = pPortDesc->DefaultOutPortNb;
-            // Data fifo memory allocation
-            pNetworkPort->pFifoRxMsg = FifoCreate(pPortDesc->RxFifoSize, sizeof(uint8_t));
-            pNetworkPort->pFifoTxMsg = FifoCreate(pPortDesc->TxFifoSize, sizeof(uint8_t));
+            // Data fifo memory allocation, fifos of a closed port are recycled
+            pNetworkPort->pFifoRxMsg = NetworkPortGetFifo(pNetworkPort->pFifoRxMsg, pPortDesc->RxFifoSize, sizeof(uint8_t));
+            pNetworkPort->pFifoTxMsg = NetworkPortGetFifo(pNetworkPort->pFifoTxMsg, pPortDesc->TxFifoSize, sizeof(uint8_t));
             // Descriptor fifo memory allocation
             if (pPortDesc->RxDescFifoSize != 0) {
-                pNetworkPort->pFifoRxMsgDesc = FifoCreate(pPortDesc->RxDescFifoSize, sizeof(network_msg_desc_t));
+                pNetworkPort->pFifoRxMsgDesc = NetworkPortGetFifo(pNetworkPort->pFifoRxMsgDesc, pPortDesc->RxDescFifoSize, sizeof(network_msg_desc_t));
                 pNetworkPort->IsVirtualComRx = false;
             }
             if (pPortDesc->TxDescFifoSize != 0) {
-                pNetworkPort->pFifoTxMsgDesc = FifoCreate(pPortDesc->TxDescFifoSize, sizeof(network_msg_desc_t));
+                pNetworkPort->pFifoTxMsgDesc = NetworkPortGetFifo(pNetworkPort->pFifoTxMsgDesc, pPortDesc->TxDescFifoSize, sizeof(network_msg_desc_t));
                 pNetworkPort->IsVirtualComTx = false;
             }
+            // Connect to the default remote endpoint
+            if ((pPortDesc->Options & NETWORK_PORT_OPT_CONNECTED) != 0) {
+                pNetworkPort->IsConnected = true;
+                NetworkLinkConnPort(portId);
+            }
+            // Update transmission order
+            NetworkSortTxPorts();
             return true;
         }
     }
@@ -1122,7 +2755,10 @@ void NetworkCtrlRxProcess(uint8_t ctrlId) {
             uint16_t dataSize;
             pNetworkCtrl->pDesc->ComInterface.MacCtrlGetMsg(pNetworkCtrl->pDesc->MacCtrlId, NetworkInfo.pBuffer, &dataSize);
             // Process data
-            if (!NetworkProcessEthPacket(ctrlId, NetworkInfo.pBuffer, dataSize)) {
+            NetworkInfo.IsRxPass = true;
+            bool processStatus = NetworkProcessEthPacket(ctrlId, NetworkInfo.pBuffer, dataSize);
+            NetworkInfo.IsRxPass = false;
+            if (!processStatus) {
                 // Something bad happened, we notify it
                 if (NetworkInfo.pInitDesc->GenInterface.pFnErrorNotify != NULL)
                     NetworkInfo.pInitDesc->GenInterface.pFnErrorNotify(NetworkInfo.pInitDesc->ErrorCode);
@@ -1133,21 +2769,31 @@ void NetworkCtrlRxProcess(uint8_t ctrlId) {
 
 void NetworkCtrlTxProcess(uint8_t ctrlId) {
     if (NetworkCtrlValid(ctrlId)) {
-        // Parse the network ports
-        for (uint8_t portIdx = 0; portIdx < NetworkInfo.pInitDesc->PortNb; portIdx++) {
+        // Parse the network ports by decreasing priority class
+        for (uint8_t orderIdx = 0; orderIdx < NetworkInfo.pInitDesc->PortNb; orderIdx++) {
+            uint8_t portIdx = NetworkInfo.pTxPortOrder[orderIdx];
+            uint32_t pendingTx;
+
             // Skip non-valid network ports
             if (!NetworkPortValid(portIdx)) {
                 continue;
             }
-            // Check if there is data to send
-            if (!NetworkPortIsTxEmpty(portIdx)) {
+            // Best effort ports send a message per pass, higher classes and batches are drained as long as they progress
+            do {
+                // Check if there is data to send
+                if (NetworkPortIsTxEmpty(portIdx)) {
+                    break;
+                }
+                pendingTx = NetworkPortTxPending(portIdx);
                 // Attempt to send the message
                 if (!NetworkProcessSendMsg(portIdx, NetworkInfo.pBuffer)) {
                     // Something bad happened, we notify it
                     if (NetworkInfo.pInitDesc->GenInterface.pFnErrorNotify != NULL)
                         NetworkInfo.pInitDesc->GenInterface.pFnErrorNotify(NetworkInfo.pInitDesc->ErrorCode);
+                    break;
                 }
-            }
+            } while (((NetworkInfo.pPortInfoList[portIdx].pDesc->Priority > NETWORK_PRIO_BEST_EFFORT) || NetworkInfo.pPortInfoList[portIdx].IsTxBatch) && (NetworkPortTxPending(portIdx) < pendingTx));
+            NetworkInfo.pPortInfoList[portIdx].IsTxBatch = false;
         }
     }
 }
@@ -1163,7 +2809,7 @@ bool NetworkCtrlAddArpEntry(uint8_t ctrlId, const uint8_t *pIpAddr, const uint8_
         network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[ctrlId]);
 
         // Add only if ip address valid for the subnet
-        if (NetworkIsIpValid(pIpAddr, pNetworkCtrl->IpAddr, pNetworkCtrl->SubnetMask)) {
+        if (NetworkIsIpValid(pIpAddr, pNetworkCtrl)) {
             return NetworkUpdateArpTable(ctrlId, pIpAddr, pMacAddr, hasDecay);
         }
     }
@@ -1175,7 +2821,7 @@ bool NetworkCtrlForceRequestARP(uint8_t ctrlId, const uint8_t *pIpAddr) {
         network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[ctrlId]);
 
         // Send request only if ip valid for the subnet
-        if (NetworkIsIpValid(pIpAddr, pNetworkCtrl->IpAddr, pNetworkCtrl->SubnetMask)) {
+        if (NetworkIsIpValid(pIpAddr, pNetworkCtrl)) {
             return NetworkRequestArp(ctrlId, pIpAddr);
         }
     }
@@ -1235,7 +2881,7 @@ bool NetworkPortIsTxEmpty(uint8_t portId) {
 
 bool NetworkPortSendByte(uint8_t portId, uint8_t data, const uint8_t *pIpDest) {
     if (NetworkPortValid(portId)) {
-        return NetworkStoreSendData(portId, &data, sizeof(data), pIpDest);
+        return NetworkStoreSendData(portId, &data, sizeof(data), pIpDest, 0);
     } else {
         return false;
     }
@@ -1245,8 +2891,8 @@ bool NetworkPortSendString(uint8_t portId, const char *str, const uint8_t *pIpDe
     if (NetworkPortValid(portId) && (str != NULL)) {
         uint16_t strLgth = (uint16_t)strlen(str);
 
-        if (NetworkInfo.pPortInfoList[portId].IsVirtualComTx || (strLgth <= ETHERNET_MAX_DATA_SIZE)) {
-            return NetworkStoreSendData(portId, (uint8_t*)str, strLgth, pIpDest);
+        if (NetworkInfo.pPortInfoList[portId].IsVirtualComTx || (strLgth <= NetworkPortMaxMsgSize(portId))) {
+            return NetworkStoreSendData(portId, (uint8_t*)str, strLgth, pIpDest, 0);
         }
     }
     return false;
@@ -1254,8 +2900,8 @@ bool NetworkPortSendString(uint8_t portId, const char *str, const uint8_t *pIpDe
 
 bool NetworkPortSendBuff(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const uint8_t *pIpDest) {
     if (NetworkPortValid(portId) && (pBuffer != NULL)) {
-        if (NetworkInfo.pPortInfoList[portId].IsVirtualComTx || (buffSize <= ETHERNET_MAX_DATA_SIZE)) {
-            return NetworkStoreSendData(portId, pBuffer, buffSize, pIpDest);
+        if (NetworkInfo.pPortInfoList[portId].IsVirtualComTx || (buffSize <= NetworkPortMaxMsgSize(portId))) {
+            return NetworkStoreSendData(portId, pBuffer, buffSize, pIpDest, 0);
         }
     }
     return false;
@@ -1352,6 +2998,7 @@ uint8_t *NetworkCtrlGetIpAddress(uint8_t ctrlId) {
 bool NetworkCtrlSetIpAddress(uint8_t ctrlId, const uint8_t *pNewIpAddr) {
     if (NetworkCtrlValid(ctrlId) && (pNewIpAddr != NULL)) {
         memcpy(NetworkInfo.pCtrlInfoList[ctrlId].IpAddr, pNewIpAddr, IP_ADDR_LENGTH);
+        NetworkUpdateCtrlAddr(&(NetworkInfo.pCtrlInfoList[ctrlId]));
         return true;
     } else {
         return false;
@@ -1369,12 +3016,79 @@ uint8_t *NetworkCtrlGetSubnetMask(uint8_t ctrlId) {
 bool NetworkCtrlSetSubnetMask(uint8_t ctrlId, const uint8_t *pNewSubnetMask) {
     if (NetworkCtrlValid(ctrlId) && (pNewSubnetMask != NULL)) {
         memcpy(NetworkInfo.pCtrlInfoList[ctrlId].SubnetMask, pNewSubnetMask, IP_ADDR_LENGTH);
+        NetworkUpdateCtrlAddr(&(NetworkInfo.pCtrlInfoList[ctrlId]));
         return true;
     } else {
         return false;
     }
 }
 
+bool NetworkCtrlAddIpAlias(uint8_t ctrlId, const uint8_t *pIpAddr, const uint8_t *pSubnetMask) {
+    if (NetworkCtrlValid(ctrlId) && (pIpAddr != NULL) && (pSubnetMask != NULL)) {
+        network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[ctrlId]);
+
+        if ((pNetworkCtrl->AddrNb <= pNetworkCtrl->pDesc->IpAliasNb) && (NetworkGetLocalAddr(pIpAddr, pNetworkCtrl) == NULL)) {
+            NetworkSetAddrInfo(&(pNetworkCtrl->pAddrArray[pNetworkCtrl->AddrNb]), pIpAddr, pSubnetMask);
+            pNetworkCtrl->AddrNb++;
+            NetworkFlushRouteCache(pNetworkCtrl);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NetworkCtrlRemoveIpAlias(uint8_t ctrlId, const uint8_t *pIpAddr) {
+    if (NetworkCtrlValid(ctrlId) && (pIpAddr != NULL)) {
+        network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[ctrlId]);
+        const ip_addr_info_t *pAddr = NetworkGetLocalAddr(pIpAddr, pNetworkCtrl);
+
+        // The primary address is not an alias
+        if ((pAddr != NULL) && (pAddr != &(pNetworkCtrl->pAddrArray[0]))) {
+            uint8_t addrIdx = (uint8_t)(pAddr - pNetworkCtrl->pAddrArray);
+
+            // Keep aliases packed, the last one takes the freed place
+            pNetworkCtrl->AddrNb--;
+            pNetworkCtrl->pAddrArray[addrIdx] = pNetworkCtrl->pAddrArray[pNetworkCtrl->AddrNb];
+            NetworkFlushRouteCache(pNetworkCtrl);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NetworkCtrlAddRoute(uint8_t ctrlId, const uint8_t *pNetAddr, const uint8_t *pNetMask, const uint8_t *pGateway) {
+    if (NetworkCtrlValid(ctrlId) && (pNetAddr != NULL) && (pNetMask != NULL) && (pGateway != NULL)) {
+        network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[ctrlId]);
+        uint32_t maskWord = NetworkIpWord(pNetMask);
+
+        // The default route is reserved to the default gateway
+        if (maskWord != 0) {
+            return NetworkSetRoute(pNetworkCtrl, NetworkIpWord(pNetAddr), maskWord, pGateway);
+        }
+    }
+    return false;
+}
+
+bool NetworkCtrlRemoveRoute(uint8_t ctrlId, const uint8_t *pNetAddr, const uint8_t *pNetMask) {
+    if (NetworkCtrlValid(ctrlId) && (pNetAddr != NULL) && (pNetMask != NULL) && (NetworkIpWord(pNetMask) != 0)) {
+        return NetworkDeleteRoute(&(NetworkInfo.pCtrlInfoList[ctrlId]), NetworkIpWord(pNetAddr), NetworkIpWord(pNetMask));
+    }
+    return false;
+}
+
+bool NetworkCtrlSetGateway(uint8_t ctrlId, const uint8_t *pGateway) {
+    if (NetworkCtrlValid(ctrlId) && (pGateway != NULL)) {
+        network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[ctrlId]);
+
+        if (NetworkIpWord(pGateway) == 0) {
+            NetworkDeleteRoute(pNetworkCtrl, 0, 0);
+            return true;
+        }
+        return NetworkSetRoute(pNetworkCtrl, 0, 0, pGateway);
+    }
+    return false;
+}
+
 uint8_t *NetworkPortGetDstIpAddress(uint8_t portId) {
     if (NetworkPortValid(portId)) {
         return NetworkInfo.pPortInfoList[portId].DstIpAddr;
@@ -1386,10 +3100,15 @@ uint8_t *NetworkPortGetDstIpAddress(uint8_t portId) {
 bool NetworkPortSetDstIpAddress(uint8_t portId, const uint8_t *pNewIpAddr) {
     if (NetworkPortValid(portId) && (pNewIpAddr != NULL)) {
         network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[NetworkInfo.pPortInfoList[portId].pDesc->NetworkCtrlId]);
+        uint8_t nextHop[IP_ADDR_LENGTH];
 
-        // Change ip address only if valid for the subnet
-        if (NetworkIsIpValid(pNewIpAddr, pNetworkCtrl->IpAddr, pNetworkCtrl->SubnetMask)) {
+        // Change ip address only if reachable
+        if (NetworkGetNextHop(pNetworkCtrl, pNewIpAddr, nextHop)) {
+            NetworkUnlinkConnPort(portId);
             memcpy(NetworkInfo.pPortInfoList[portId].DstIpAddr, pNewIpAddr, IP_ADDR_LENGTH);
+            if (NetworkInfo.pPortInfoList[portId].IsConnected) {
+                NetworkLinkConnPort(portId);
+            }
             return true;
         }
     }
@@ -1406,7 +3125,11 @@ uint16_t NetworkPortGetInPortNb(uint8_t portId) {
 
 bool NetworkPortSetInPortNb(uint8_t portId, uint16_t newInPortNb) {
     if (NetworkPortValid(portId)) {
+        NetworkUnlinkConnPort(portId);
         NetworkInfo.pPortInfoList[portId].InPortNb = newInPortNb;
+        if (NetworkInfo.pPortInfoList[portId].IsConnected) {
+            NetworkLinkConnPort(portId);
+        }
         return true;
     } else {
         return false;
@@ -1423,9 +3146,352 @@ uint16_t NetworkPortGetOutPortNb(uint8_t portId) {
 
 bool NetworkPortSetOutPortNb(uint8_t portId, uint16_t newOutPortNb) {
     if (NetworkPortValid(portId)) {
+        NetworkUnlinkConnPort(portId);
         NetworkInfo.pPortInfoList[portId].OutPortNb = newOutPortNb;
+        if (NetworkInfo.pPortInfoList[portId].IsConnected) {
+            NetworkLinkConnPort(portId);
+        }
+        return true;
+    } else {
+        return false;
+    }
+}
+
+bool NetworkPortGetStats(uint8_t portId, network_port_stats_t *pStats) {
+    if (NetworkPortValid(portId) && (pStats != NULL)) {
+        memcpy(pStats, &NetworkInfo.pPortInfoList[portId].Stats, sizeof(network_port_stats_t));
         return true;
     } else {
         return false;
     }
-}
\ No newline at end of file
+}
+
+bool NetworkPortJoinGroup(uint8_t portId, const uint8_t *pGroupAddr) {
+    if (NetworkPortValid(portId) && (pGroupAddr != NULL) && NetworkIsIpMulticast(pGroupAddr) && (NetworkIpWord(pGroupAddr) != NetworkIpWord(NetworkMcastAllHosts))) {
+        uint8_t ctrlId = NetworkInfo.pPortInfoList[portId].pDesc->NetworkCtrlId;
+        network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[ctrlId]);
+        uint32_t groupWord = NetworkIpWord(pGroupAddr);
+        mcast_group_t *pGroup = NetworkGetMcastGroup(pNetworkCtrl, groupWord);
+
+        if (pGroup == NULL) {
+            pGroup = NetworkAddMcastGroup(pNetworkCtrl, groupWord);
+            if (pGroup == NULL) {
+                return false;
+            }
+        }
+        if ((pGroup->pPortMap[portId / 8] & (1 << (portId % 8))) == 0) {
+            pGroup->pPortMap[portId / 8] |= (uint8_t)(1 << (portId % 8));
+            pGroup->PortCount++;
+            // First subscriber: open the mac filter and announce the group (queries refresh lost reports)
+            if (pGroup->PortCount == 1) {
+                pNetworkCtrl->McastMacFilter |= (uint64_t)1 << NetworkMcastMacHash(pGroupAddr);
+                NetworkSendIgmpMessage(ctrlId, IGMP_V2_MEMBERSHIP_REPORT, groupWord);
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+bool NetworkPortLeaveGroup(uint8_t portId, const uint8_t *pGroupAddr) {
+    if (NetworkPortValid(portId) && (pGroupAddr != NULL)) {
+        uint8_t ctrlId = NetworkInfo.pPortInfoList[portId].pDesc->NetworkCtrlId;
+        network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[ctrlId]);
+        uint32_t groupWord = NetworkIpWord(pGroupAddr);
+        mcast_group_t *pGroup = NetworkGetMcastGroup(pNetworkCtrl, groupWord);
+
+        if ((pGroup != NULL) && ((pGroup->pPortMap[portId / 8] & (1 << (portId % 8))) != 0)) {
+            pGroup->pPortMap[portId / 8] &= (uint8_t)~(1 << (portId % 8));
+            pGroup->PortCount--;
+            // Last subscriber: close the mac filter and tell the routers
+            if (pGroup->PortCount == 0) {
+                NetworkRemoveMcastGroup(pNetworkCtrl, pGroup);
+                NetworkSendIgmpMessage(ctrlId, IGMP_LEAVE_GROUP, groupWord);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NetworkPortConnect(uint8_t portId, const uint8_t *pRemoteIpAddr, uint16_t remotePortNb) {
+    if (NetworkPortValid(portId) && (pRemoteIpAddr != NULL) && !NetworkIsIpMulticast(pRemoteIpAddr)) {
+        network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[NetworkInfo.pPortInfoList[portId].pDesc->NetworkCtrlId]);
+        uint8_t nextHop[IP_ADDR_LENGTH];
+
+        // Connect only to a reachable endpoint
+        if (NetworkGetNextHop(pNetworkCtrl, pRemoteIpAddr, nextHop)) {
+            NetworkUnlinkConnPort(portId);
+            memcpy(NetworkInfo.pPortInfoList[portId].DstIpAddr, pRemoteIpAddr, IP_ADDR_LENGTH);
+            NetworkInfo.pPortInfoList[portId].OutPortNb = remotePortNb;
+            NetworkInfo.pPortInfoList[portId].IsConnected = true;
+            NetworkLinkConnPort(portId);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NetworkPortDisconnect(uint8_t portId) {
+    if (NetworkPortValid(portId) && NetworkInfo.pPortInfoList[portId].IsConnected) {
+        NetworkUnlinkConnPort(portId);
+        NetworkInfo.pPortInfoList[portId].IsConnected = false;
+        return true;
+    }
+    return false;
+}
+
+bool NetworkPortOpen(const network_port_desc_t *pPortDesc, uint8_t *pPortId) {
+    if ((pPortDesc != NULL) && (pPortId != NULL)) {
+        uint8_t freePortId = NETWORK_PORT_NONE;
+
+        // A closed port with large enough fifos first, a never used one otherwise
+        for (uint8_t portId = 0; portId < NetworkInfo.pInitDesc->PortNb; portId++) {
+            if (NetworkPortValid(portId)) {
+                continue;
+            } else if (NetworkPortFifosFit(portId, pPortDesc)) {
+                freePortId = portId;
+                break;
+            } else if ((freePortId == NETWORK_PORT_NONE) && (NetworkInfo.pPortInfoList[portId].pFifoRxMsg == NULL)) {
+                freePortId = portId;
+            }
+        }
+        if ((freePortId != NETWORK_PORT_NONE) && NetworkPortAdd(freePortId, pPortDesc)) {
+            *pPortId = freePortId;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NetworkPortClose(uint8_t portId) {
+    if (NetworkPortValid(portId)) {
+        network_port_info_t *pNetworkPort = &(NetworkInfo.pPortInfoList[portId]);
+        network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[pNetworkPort->pDesc->NetworkCtrlId]);
+
+        NetworkUnlinkConnPort(portId);
+        pNetworkPort->IsConnected = false;
+        // Leave joined groups, a left group can move the others so the table is parsed again
+        uint8_t groupIdx = 0;
+        while (groupIdx < pNetworkCtrl->pDesc->McastGroupNb) {
+            const mcast_group_t *pGroup = &(pNetworkCtrl->pMcastArray[groupIdx]);
+
+            if ((pGroup->PortCount != 0) && ((pGroup->pPortMap[portId / 8] & (1 << (portId % 8))) != 0)) {
+                uint8_t groupAddr[IP_ADDR_LENGTH];
+
+                memcpy(groupAddr, &(pGroup->GroupWord), IP_ADDR_LENGTH);
+                NetworkPortLeaveGroup(portId, groupAddr);
+                groupIdx = 0;
+            } else {
+                groupIdx++;
+            }
+        }
+        // Fifos are kept for the next opened port
+        pNetworkPort->pDesc = NULL;
+        NetworkSortTxPorts();
+        return true;
+    }
+    return false;
+}
+
+network_sock_status_t NetworkPortSendTo(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const network_endpoint_t *pDst, uint8_t flags) {
+    if (!NetworkPortValid(portId) || (pBuffer == NULL) || NetworkInfo.pPortInfoList[portId].IsVirtualComTx) {
+        return NETWORK_SOCK_INVALID;
+    }
+    if (buffSize > NetworkPortMaxMsgSize(portId)) {
+        return NETWORK_SOCK_TOO_BIG;
+    }
+    // Report an unreachable recipient at once, the next hop is resolved again when the message is sent
+    const uint8_t *pDstIp = (pDst != NULL) ? pDst->IpAddr : NetworkInfo.pPortInfoList[portId].DstIpAddr;
+    uint8_t nextHop[IP_ADDR_LENGTH];
+
+    if (!NetworkGetNextHop(&(NetworkInfo.pCtrlInfoList[NetworkInfo.pPortInfoList[portId].pDesc->NetworkCtrlId]), pDstIp, nextHop)) {
+        return NETWORK_SOCK_NO_ROUTE;
+    }
+    if (((flags & NETWORK_MSG_DONTROUTE) != 0) && (memcmp(nextHop, pDstIp, IP_ADDR_LENGTH) != 0)) {
+        return NETWORK_SOCK_NO_ROUTE;
+    }
+    if (!NetworkStoreSendData(portId, pBuffer, buffSize, pDstIp, (pDst != NULL) ? pDst->PortNb : 0)) {
+        return NETWORK_SOCK_WOULD_BLOCK;
+    }
+    return NETWORK_SOCK_OK;
+}
+
+network_sock_status_t NetworkPortRecvFrom(uint8_t portId, uint8_t *pBuffer, uint16_t buffSize, uint16_t *pDataSize, network_endpoint_t *pSrc, uint8_t flags) {
+    if (!NetworkPortValid(portId) || (pBuffer == NULL) || (pDataSize == NULL) || NetworkInfo.pPortInfoList[portId].IsVirtualComRx) {
+        return NETWORK_SOCK_INVALID;
+    }
+    network_port_info_t *pNetworkPort = &(NetworkInfo.pPortInfoList[portId]);
+    network_msg_desc_t msgDesc;
+
+    if (!FifoRead(pNetworkPort->pFifoRxMsgDesc, &msgDesc, 1, false)) {
+        return NETWORK_SOCK_WOULD_BLOCK;
+    }
+    // Message is left in place if it does not fit, unless it can be truncated
+    if ((msgDesc.MsgSize > buffSize) && ((flags & NETWORK_MSG_TRUNC) == 0)) {
+        return NETWORK_SOCK_TOO_BIG;
+    }
+    *pDataSize = (msgDesc.MsgSize < buffSize) ? msgDesc.MsgSize : buffSize;
+    FifoRead(pNetworkPort->pFifoRxMsg, pBuffer, *pDataSize, false);
+    if (pSrc != NULL) {
+        memcpy(pSrc->IpAddr, msgDesc.IpAddr, IP_ADDR_LENGTH);
+        pSrc->PortNb = msgDesc.PortNb;
+    }
+    // Consume the whole message, truncated data included
+    if ((flags & NETWORK_MSG_PEEK) == 0) {
+        FifoConsume(pNetworkPort->pFifoRxMsg, msgDesc.MsgSize);
+        FifoConsume(pNetworkPort->pFifoRxMsgDesc, 1);
+    }
+    return NETWORK_SOCK_OK;
+}
+
+uint16_t NetworkPortReadBatch(uint8_t portId, network_msg_entry_t *pEntries, uint16_t entryNb) {
+    uint16_t msgNb = 0;
+
+    if (NetworkPortValid(portId) && (pEntries != NULL) && !NetworkInfo.pPortInfoList[portId].IsVirtualComRx) {
+        network_port_info_t *pNetworkPort = &(NetworkInfo.pPortInfoList[portId]);
+        uint32_t descNb = FifoItemCount(pNetworkPort->pFifoRxMsgDesc);
+        uint32_t dataOffset = 0;
+        fifo_span_t descSpans[2];
+
+        if (descNb > entryNb) {
+            descNb = entryNb;
+        }
+        // Parse the descriptors in place
+        if (!FifoGetReadSpans(pNetworkPort->pFifoRxMsgDesc, 0, descNb, descSpans)) {
+            return 0;
+        }
+        while (msgNb < descNb) {
+            const network_msg_desc_t *pMsgDesc = (msgNb < descSpans[0].ItemNb) ? &(((const network_msg_desc_t *)descSpans[0].pData)[msgNb]) : &(((const network_msg_desc_t *)descSpans[1].pData)[msgNb - descSpans[0].ItemNb]);
+            network_msg_entry_t *pEntry = &(pEntries[msgNb]);
+            fifo_span_t dataSpans[2];
+
+            if ((pEntry->pBuffer == NULL) || (pMsgDesc->MsgSize > pEntry->BuffSize) || !FifoGetReadSpans(pNetworkPort->pFifoRxMsg, dataOffset, pMsgDesc->MsgSize, dataSpans)) {
+                break;
+            }
+            memcpy(pEntry->pBuffer, dataSpans[0].pData, dataSpans[0].ItemNb);
+            memcpy(pEntry->pBuffer + dataSpans[0].ItemNb, dataSpans[1].pData, dataSpans[1].ItemNb);
+            pEntry->DataSize = pMsgDesc->MsgSize;
+            memcpy(pEntry->Endpoint.IpAddr, pMsgDesc->IpAddr, IP_ADDR_LENGTH);
+            pEntry->Endpoint.PortNb = pMsgDesc->PortNb;
+            dataOffset += pMsgDesc->MsgSize;
+            msgNb++;
+        }
+        // Consume the read messages at once
+        FifoConsume(pNetworkPort->pFifoRxMsg, dataOffset);
+        FifoConsume(pNetworkPort->pFifoRxMsgDesc, msgNb);
+    }
+    return msgNb;
+}
+
+bool NetworkPortSendBatch(uint8_t portId, const network_msg_entry_t *pEntries, uint16_t entryNb) {
+    if (NetworkPortValid(portId) && (pEntries != NULL) && !NetworkInfo.pPortInfoList[portId].IsVirtualComTx) {
+        network_port_info_t *pNetworkPort = &(NetworkInfo.pPortInfoList[portId]);
+        uint16_t maxMsgSize = NetworkPortMaxMsgSize(portId);
+        uint32_t dataSize = 0;
+        fifo_span_t descSpans[2];
+
+        for (uint16_t entryIdx = 0; entryIdx < entryNb; entryIdx++) {
+            if ((pEntries[entryIdx].pBuffer == NULL) || (pEntries[entryIdx].DataSize > maxMsgSize)) {
+                return false;
+            }
+            dataSize += pEntries[entryIdx].DataSize;
+        }
+        // Reserve room for the whole batch, nothing is queued otherwise
+        if ((FifoFreeSpace(pNetworkPort->pFifoTxMsg) < dataSize) || !FifoGetWriteSpans(pNetworkPort->pFifoTxMsgDesc, entryNb, descSpans)) {
+            return false;
+        }
+        // Write the descriptors in place
+        for (uint16_t entryIdx = 0; entryIdx < entryNb; entryIdx++) {
+            network_msg_desc_t *pMsgDesc = (entryIdx < descSpans[0].ItemNb) ? &(((network_msg_desc_t *)descSpans[0].pData)[entryIdx]) : &(((network_msg_desc_t *)descSpans[1].pData)[entryIdx - descSpans[0].ItemNb]);
+
+            FifoWrite(pNetworkPort->pFifoTxMsg, pEntries[entryIdx].pBuffer, pEntries[entryIdx].DataSize);
+            pMsgDesc->MsgSize = pEntries[entryIdx].DataSize;
+            pMsgDesc->PortNb = pEntries[entryIdx].Endpoint.PortNb;
+            memcpy(pMsgDesc->IpAddr, pEntries[entryIdx].Endpoint.IpAddr, IP_ADDR_LENGTH);
+        }
+        FifoCommit(pNetworkPort->pFifoTxMsgDesc, entryNb);
+        pNetworkPort->IsTxBatch = true;
+        return true;
+    }
+    return false;
+}
+
+bool NetworkPortRecvPeek(uint8_t portId, network_sg_entry_t *pSpans, network_endpoint_t *pSrc) {
+    if (NetworkPortValid(portId) && (pSpans != NULL) && !NetworkInfo.pPortInfoList[portId].IsVirtualComRx) {
+        network_port_info_t *pNetworkPort = &(NetworkInfo.pPortInfoList[portId]);
+        network_msg_desc_t msgDesc;
+        fifo_span_t dataSpans[2];
+
+        if (FifoRead(pNetworkPort->pFifoRxMsgDesc, &msgDesc, 1, false) && FifoGetReadSpans(pNetworkPort->pFifoRxMsg, 0, msgDesc.MsgSize, dataSpans)) {
+            for (uint8_t spanIdx = 0; spanIdx < 2; spanIdx++) {
+                pSpans[spanIdx].pData = dataSpans[spanIdx].pData;
+                pSpans[spanIdx].Size = (uint16_t)dataSpans[spanIdx].ItemNb;
+            }
+            if (pSrc != NULL) {
+                memcpy(pSrc->IpAddr, msgDesc.IpAddr, IP_ADDR_LENGTH);
+                pSrc->PortNb = msgDesc.PortNb;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NetworkPortRecvRelease(uint8_t portId) {
+    if (NetworkPortValid(portId) && !NetworkInfo.pPortInfoList[portId].IsVirtualComRx) {
+        network_port_info_t *pNetworkPort = &(NetworkInfo.pPortInfoList[portId]);
+        network_msg_desc_t msgDesc;
+
+        if (FifoRead(pNetworkPort->pFifoRxMsgDesc, &msgDesc, 1, true)) {
+            return FifoConsume(pNetworkPort->pFifoRxMsg, msgDesc.MsgSize);
+        }
+    }
+    return false;
+}
+
+bool NetworkPortSendNow(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const uint8_t *pIpDest) {
+    if (NetworkPortValid(portId) && (pBuffer != NULL)) {
+        network_port_info_t *pNetworkPort = &(NetworkInfo.pPortInfoList[portId]);
+        uint8_t ctrlId = pNetworkPort->pDesc->NetworkCtrlId;
+        network_ctrl_info_t *pNetworkCtrl = &(NetworkInfo.pCtrlInfoList[ctrlId]);
+        const uint8_t *pDestIp = ((pIpDest != NULL) && !pNetworkPort->IsVirtualComTx && (NetworkIpWord(pIpDest) != 0)) ? pIpDest : pNetworkPort->DstIpAddr;
+        uint8_t nextHop[IP_ADDR_LENGTH];
+
+        // Cut-through only for a single datagram that would be sent first anyway, and not from an rx callback
+        if (!NetworkInfo.IsRxPass && (NetworkPortTxPending(portId) == 0) && (buffSize <= NetworkPortMaxDataSize(portId)) && ((pNetworkPort->pDesc->Options & NETWORK_PORT_OPT_AGGREGATE) == 0) && NetworkGetNextHop(pNetworkCtrl, pDestIp, nextHop)) {
+            arp_entry_t *pArpEntry = NetworkGetArpEntry(ctrlId, nextHop);
+
+            if ((NetworkIsIpBroadcast(pDestIp, pNetworkCtrl) || NetworkIsIpMulticast(pDestIp) || ((pArpEntry != NULL) && pArpEntry->Status.IsValid)) && NetworkShaperAllow(portId, (uint32_t)NETWORK_HEADER_SIZE + buffSize)) {
+                uint8_t capabilities = pNetworkCtrl->pDesc->ComInterface.Capabilities;
+                fifo_span_t spans[2] = {{(uint8_t *)pBuffer, buffSize}, {NULL, 0}};
+                network_msg_info_t msgInfo;
+
+                NetworkInitMsgInfo(&msgInfo, pDestIp, pNetworkPort->InPortNb, pNetworkPort->OutPortNb, buffSize);
+                msgInfo.Dscp = NetworkPrioDscp[pNetworkPort->pDesc->Priority];
+                msgInfo.HasUdpChecksum = ((pNetworkPort->pDesc->Options & NETWORK_PORT_OPT_UDP_CKSUM) != 0) && ((capabilities & NETWORK_CAP_TX_UDP_CKSUM) == 0);
+                // Send the data straight from the caller buffer if the mac can gather it
+                if ((capabilities & NETWORK_CAP_SCATTER_GATHER) != 0) {
+                    msgInfo.pDataSpans = spans;
+                    if (msgInfo.HasUdpChecksum) {
+                        msgInfo.DataSum = NetworkSumBytes(pBuffer, buffSize, 0, false);
+                    }
+                } else if (msgInfo.HasUdpChecksum) {
+                    msgInfo.DataSum = NetworkCopyAndSum(NetworkInfo.pBuffer + NETWORK_HEADER_SIZE, pBuffer, buffSize, 0, false);
+                } else {
+                    memcpy(NetworkInfo.pBuffer + NETWORK_HEADER_SIZE, pBuffer, buffSize);
+                }
+                if (NetworkSendUdpPacket(ctrlId, NetworkInfo.pBuffer, msgInfo)) {
+                    return true;
+                }
+                // Mac busy, the message is queued and its tokens are given back
+                NetworkShaperRefund(portId, (uint32_t)NETWORK_HEADER_SIZE + buffSize);
+            }
+        }
+        // Queue the message otherwise
+        if (pNetworkPort->IsVirtualComTx || (buffSize <= NetworkPortMaxMsgSize(portId))) {
+            return NetworkStoreSendData(portId, pBuffer, buffSize, pIpDest, 0);
+        }
+    }
+    return false;
+}
@@ -37,6 +37,13 @@ typedef bool network_mac_ctrl_has_msg_ft(uint8_t ctrlId);
 typedef bool network_mac_ctrl_get_msg_ft(uint8_t ctrlId, uint8_t *message, uint16_t *messageSize);
 typedef bool network_mac_ctrl_send_msg_ft(uint8_t ctrlId, const uint8_t *message, uint16_t messageSize);
 
+typedef struct _network_sg_entry {
+    const uint8_t *pData;
+    uint16_t Size;
+} network_sg_entry_t;
+
+typedef bool network_mac_ctrl_send_msg_sg_ft(uint8_t ctrlId, const network_sg_entry_t *pEntries, uint8_t entryNb);
+
 typedef struct _network_gen_itfc {
     error_notify_ft *pFnErrorNotify; // function called in case of errors (optional)
     timer_get_time_ft *pFnTimerGetTime;
@@ -55,6 +62,8 @@ typedef struct _network_com_itfc {
     network_mac_ctrl_has_msg_ft* MacCtrlHasMsg;
     network_mac_ctrl_get_msg_ft* MacCtrlGetMsg;
     network_mac_ctrl_send_msg_ft* MacCtrlSendMsg;
+    uint8_t Capabilities; // mac controller offloads (NETWORK_CAP_* flags), missing ones are done in software
+    network_mac_ctrl_send_msg_sg_ft* MacCtrlSendMsgSg; // gathered frame send (NETWORK_CAP_SCATTER_GATHER only)
 } network_com_itfc_t;
 
 typedef struct _network_ctrl_desc {
@@ -64,21 +73,94 @@ typedef struct _network_ctrl_desc {
     uint8_t DefaultSubnetMask[IP_ADDR_LENGTH];
     uint8_t MacCtrlId; // mac controller id associated to this controller
     uint8_t ArpEntryNb; // number of ARP entries in the controller ARP table
+    uint8_t ReasmContextNb; // number of ip datagrams reassembled at once (0: incoming fragments are dropped)
+    uint16_t ReasmMaxSize; // max reassembled udp datagram size (bytes), each context uses about ReasmMaxSize * 65 / 64 + 96 bytes
+    uint16_t Mtu; // max ip packet size (bytes) from IPV4_MIN_MTU to ETHERNET_JUMBO_PAYLOAD_SIZE (0: ETHERNET_PAYLOAD_SIZE), the module buffer is sized for the largest controller frame
+    uint8_t IpAliasNb; // max number of additional ip addresses of the controller
+    uint8_t RouteNb; // max number of routes besides the default gateway (0: only the default gateway)
+    uint8_t McastGroupNb; // max number of multicast groups joined on the controller (0: multicast reception disabled)
 } network_ctrl_desc_t;
 
+typedef enum _network_prio {
+    NETWORK_PRIO_BEST_EFFORT = 0, // Default class, bulk traffic (DSCP CS0)
+    NETWORK_PRIO_CRITICAL, // Critical data (DSCP AF31)
+    NETWORK_PRIO_REAL_TIME, // Real-time traffic (DSCP EF)
+    NETWORK_PRIO_CONTROL, // Control traffic (DSCP CS6)
+    NETWORK_PRIO_NB,
+} network_prio_t;
+
+typedef struct _network_endpoint {
+    uint8_t IpAddr[IP_ADDR_LENGTH];
+    uint16_t PortNb;
+} network_endpoint_t;
+
+typedef bool network_port_rx_ft(uint8_t portId, const uint8_t *pData, uint16_t dataSize, const network_endpoint_t *pSrc);
+
 typedef struct _network_port_desc {
     uint8_t NetworkCtrlId; // network controller id associated to this port
     uint8_t Protocol;
     uint8_t DefaultDstIpAddr[IP_ADDR_LENGTH];
-    uint16_t DefaultInPortNb;
+    uint16_t DefaultInPortNb; // Local port nb (0: ephemeral port)
     uint16_t DefaultOutPortNb;
     uint16_t RxFifoSize; // Rx fifo size (in bytes)
     uint16_t RxDescFifoSize; // Rx fifo size (in message number), if 0 reception will be in COM port mode
     uint16_t TxFifoSize; // Tx fifo size (in bytes)
     uint16_t TxDescFifoSize; // Tx fifo size (in message number), if 0 transmission will be in COM port mode
+    uint8_t Priority; // Tx priority class (network_prio_t), higher classes are always served first
+    uint32_t TxRateLimit; // Tx rate limit (bytes/s, ethernet frames included), if 0 transmission is not shaped
+    uint16_t TxBurstSize; // Tx burst size (bytes), amount that can be sent at once when the port was idle
+    uint16_t TxCoalesceSize; // Tx virtual com port: data amount to gather before sending (bytes), if 0 data is sent on every pass
+    uint16_t TxCoalesceDelay; // Tx virtual com port: max time data is held back while gathering (timer unit)
+    uint8_t Options; // Port options (NETWORK_PORT_OPT_* flags)
+    network_port_rx_ft *pFnRxCallback; // Called in the rx pass with each received message, the message is not stored if it returns true (optional, descriptor mode only)
 } network_port_desc_t;
 
+typedef struct _network_msg_entry {
+    uint8_t *pBuffer; // Message buffer
+    uint16_t BuffSize; // Message buffer size
+    uint16_t DataSize; // Read message size (read) or message size (send)
+    network_endpoint_t Endpoint; // Sender endpoint (read) or recipient endpoint (send, null ip address or port nb: port default)
+} network_msg_entry_t;
+
+typedef enum _network_sock_status {
+    NETWORK_SOCK_OK = 0, // Message queued or received
+    NETWORK_SOCK_WOULD_BLOCK, // No message received or no room to queue it, try again later
+    NETWORK_SOCK_NO_ROUTE, // Recipient unreachable
+    NETWORK_SOCK_TOO_BIG, // Message larger than the port max message size or the receive buffer
+    NETWORK_SOCK_INVALID, // Invalid port or parameter, or port in virtual com mode
+} network_sock_status_t;
+
+typedef struct _network_port_stats {
+    uint32_t ShaperDelay; // total time the tx shaper held back traffic (timer unit)
+    uint32_t ShaperHoldNb; // number of times the tx shaper held back traffic
+} network_port_stats_t;
+
 // --- Public Constants ---
+// Mac controller capabilities
+#define NETWORK_CAP_TX_IPV4_CKSUM 0x01 // Mac fills the ipv4 header checksum of sent frames
+#define NETWORK_CAP_RX_IPV4_CKSUM 0x02 // Mac drops received frames with a bad ipv4 header checksum
+#define NETWORK_CAP_TX_UDP_CKSUM 0x04 // Mac fills the udp checksum of sent datagrams (fragmented ones excepted)
+#define NETWORK_CAP_RX_UDP_CKSUM 0x08 // Mac drops received datagrams with a bad udp checksum (fragmented ones excepted)
+#define NETWORK_CAP_TX_SEGMENT 0x10 // Mac splits a gathered udp frame in datagrams of the header size, updating lengths and checksums (needs NETWORK_CAP_SCATTER_GATHER)
+#define NETWORK_CAP_SCATTER_GATHER 0x20 // Mac sends frames gathered from several buffers with MacCtrlSendMsgSg
+
+// Network port options
+#define NETWORK_PORT_OPT_AGGREGATE 0x01 // Pack queued messages for the same recipient in one datagram (length-prefixed framing, descriptor mode only)
+#define NETWORK_PORT_OPT_SEGMENT 0x02 // Accept messages up to 64 KiB, sent as consecutive max size datagrams (descriptor mode only)
+#define NETWORK_PORT_OPT_FRAGMENT 0x04 // Accept messages up to UDP_MAX_DATA_SIZE, sent as one fragmented ip datagram (descriptor mode only)
+#define NETWORK_PORT_OPT_UDP_CKSUM 0x08 // Fill the udp checksum of sent datagrams and drop received ones with a bad checksum
+#define NETWORK_PORT_OPT_REUSEPORT 0x10 // Share received datagrams with the other ports of this option bound to the same local port, one port per sender flow
+#define NETWORK_PORT_OPT_CONNECTED 0x20 // Connect the port to its default recipient ip address and distant port (see NetworkPortConnect)
+
+// Send and receive flags
+#define NETWORK_MSG_PEEK 0x01 // Receive: read the message without consuming it
+#define NETWORK_MSG_TRUNC 0x02 // Receive: truncate a message larger than the buffer, the remaining data is discarded
+#define NETWORK_MSG_DONTROUTE 0x04 // Send: recipient must be on-link, gateways are not used
+
+// Ephemeral local ports (IANA dynamic range), allocated to ports with a null DefaultInPortNb
+#define NETWORK_EPHEMERAL_PORT_MIN 49152
+#define NETWORK_EPHEMERAL_PORT_MAX 65535
+
 // --- Public Variables ---
 // --- Public Function Prototypes ---
 
@@ -131,7 +213,7 @@ void NetworkCtrlRxProcess(uint8_t ctrlId);
 
 /**
  * \fn void NetworkCtrlTxProcess(uint8_t ctrlId)
- * \brief Network controller transmission process
+ * \brief Network controller transmission process (ports are served by decreasing priority class)
  *
  * \param ctrlId network controller id
  * \return void
@@ -245,7 +327,7 @@ bool NetworkPortSendString(uint8_t portId, const char *str, const uint8_t *pIpDe
  *
  * \param portId network port id
  * \param pBuffer pointeur to the data buffer to send
- * \param buffSize buffer size
+ * \param buffSize buffer size (up to the controller mtu minus ip and udp headers in descriptor mode, unless NETWORK_PORT_OPT_SEGMENT or NETWORK_PORT_OPT_FRAGMENT is set)
  * \param pIpDest recipient ip address (optional)
  * \return bool: true if stored successfully in the send fifo
  */
@@ -340,6 +422,65 @@ uint8_t *NetworkCtrlGetSubnetMask(uint8_t ctrlId);
  */
 bool NetworkCtrlSetSubnetMask(uint8_t ctrlId, uint8_t const *pNewSubnetMask);
 
+/**
+ * \fn bool NetworkCtrlAddIpAlias(uint8_t ctrlId, const uint8_t *pIpAddr, const uint8_t *pSubnetMask)
+ * \brief Add an ip address to a network controller, possibly on another subnet
+ *
+ * The controller accepts packets and answers arp requests for every alias,
+ * packets sent to an alias subnet use the alias as source address.
+ *
+ * \param ctrlId network controller id
+ * \param pIpAddr pointer to the alias ip address
+ * \param pSubnetMask pointer to the alias subnet mask
+ * \return bool: true if added, false if invalid, already used or the alias table is full
+ */
+bool NetworkCtrlAddIpAlias(uint8_t ctrlId, const uint8_t *pIpAddr, const uint8_t *pSubnetMask);
+
+/**
+ * \fn bool NetworkCtrlRemoveIpAlias(uint8_t ctrlId, const uint8_t *pIpAddr)
+ * \brief Remove an ip address alias of a network controller
+ *
+ * \param ctrlId network controller id
+ * \param pIpAddr pointer to the alias ip address
+ * \return bool: true if removed, false if invalid or not found
+ */
+bool NetworkCtrlRemoveIpAlias(uint8_t ctrlId, const uint8_t *pIpAddr);
+
+/**
+ * \fn bool NetworkCtrlAddRoute(uint8_t ctrlId, const uint8_t *pNetAddr, const uint8_t *pNetMask, const uint8_t *pGateway)
+ * \brief Add or replace a route toward a remote network
+ *
+ * Off-subnet recipients are sent to the gateway of the longest matching route, then to the default gateway.
+ *
+ * \param ctrlId network controller id
+ * \param pNetAddr pointer to the remote network address
+ * \param pNetMask pointer to the remote network mask (contiguous)
+ * \param pGateway pointer to the gateway ip address, on a controller subnet
+ * \return bool: true if added, false if invalid or the routing table is full
+ */
+bool NetworkCtrlAddRoute(uint8_t ctrlId, const uint8_t *pNetAddr, const uint8_t *pNetMask, const uint8_t *pGateway);
+
+/**
+ * \fn bool NetworkCtrlRemoveRoute(uint8_t ctrlId, const uint8_t *pNetAddr, const uint8_t *pNetMask)
+ * \brief Remove a route toward a remote network
+ *
+ * \param ctrlId network controller id
+ * \param pNetAddr pointer to the remote network address
+ * \param pNetMask pointer to the remote network mask
+ * \return bool: true if removed, false if invalid or not found
+ */
+bool NetworkCtrlRemoveRoute(uint8_t ctrlId, const uint8_t *pNetAddr, const uint8_t *pNetMask);
+
+/**
+ * \fn bool NetworkCtrlSetGateway(uint8_t ctrlId, const uint8_t *pGateway)
+ * \brief Set the default gateway of a network controller
+ *
+ * \param ctrlId network controller id
+ * \param pGateway pointer to the gateway ip address, on a controller subnet (0.0.0.0: no default gateway)
+ * \return bool: true if modified successfully
+ */
+bool NetworkCtrlSetGateway(uint8_t ctrlId, const uint8_t *pGateway);
+
 /**
  * \fn uint8_t *NetworkPortGetDstIpAddress(uint8_t portId)
  * \brief Return a network port current dest ip address
@@ -397,5 +538,172 @@ uint16_t NetworkPortGetOutPortNb(uint8_t portId);
  */
 bool NetworkPortSetOutPortNb(uint8_t portId, uint16_t newOutPortNb);
 
+/**
+ * \fn bool NetworkPortGetStats(uint8_t portId, network_port_stats_t *pStats)
+ * \brief Returns a network port statistics
+ *
+ * \param portId network port id
+ * \param pStats pointer to contain the port statistics
+ * \return bool: true if statistics were retrieved
+ */
+bool NetworkPortGetStats(uint8_t portId, network_port_stats_t *pStats);
+
+/**
+ * \fn bool NetworkPortJoinGroup(uint8_t portId, const uint8_t *pGroupAddr)
+ * \brief Subscribe a network port to a multicast group
+ *
+ * The first port joining a group on a controller announces it with an igmp report.
+ *
+ * \param portId network port id
+ * \param pGroupAddr pointer to the multicast group address
+ * \return bool: true if joined, false if invalid or the controller group table is full
+ */
+bool NetworkPortJoinGroup(uint8_t portId, const uint8_t *pGroupAddr);
+
+/**
+ * \fn bool NetworkPortLeaveGroup(uint8_t portId, const uint8_t *pGroupAddr)
+ * \brief Unsubscribe a network port from a multicast group
+ *
+ * The last port leaving a group on a controller announces it with an igmp leave.
+ *
+ * \param portId network port id
+ * \param pGroupAddr pointer to the multicast group address
+ * \return bool: true if left, false if invalid or not joined
+ */
+bool NetworkPortLeaveGroup(uint8_t portId, const uint8_t *pGroupAddr);
+
+/**
+ * \fn bool NetworkPortConnect(uint8_t portId, const uint8_t *pRemoteIpAddr, uint16_t remotePortNb)
+ * \brief Connect a network port to a remote endpoint, it becomes its recipient and only source
+ *
+ * Datagrams are demultiplexed by endpoints before any copy: several connected ports can share a local port.
+ *
+ * \param portId network port id
+ * \param pRemoteIpAddr pointer to the remote ip address (unicast)
+ * \param remotePortNb remote port
+ * \return bool: true if connected
+ */
+bool NetworkPortConnect(uint8_t portId, const uint8_t *pRemoteIpAddr, uint16_t remotePortNb);
+
+/**
+ * \fn bool NetworkPortDisconnect(uint8_t portId)
+ * \brief Disconnect a network port, it receives datagrams from any source again
+ *
+ * \param portId network port id
+ * \return bool: true if disconnected, false if invalid or not connected
+ */
+bool NetworkPortDisconnect(uint8_t portId);
+
+/**
+ * \fn bool NetworkPortOpen(const network_port_desc_t *pPortDesc, uint8_t *pPortId)
+ * \brief Add a network port in a free port slot, for short-lived ports
+ *
+ * Fifos of closed ports are recycled when large enough, so that ports can be opened and closed per transaction.
+ *
+ * \param pPortDesc pointer to the network port descriptor (null DefaultInPortNb for an ephemeral local port)
+ * \param pPortId pointer to contain the network port id
+ * \return bool: true if opened, false if invalid or no port slot is free
+ */
+bool NetworkPortOpen(const network_port_desc_t *pPortDesc, uint8_t *pPortId);
+
+/**
+ * \fn bool NetworkPortClose(uint8_t portId)
+ * \brief Remove a network port, pending data is discarded and joined groups are left
+ *
+ * \param portId network port id
+ * \return bool: true if closed
+ */
+bool NetworkPortClose(uint8_t portId);
+
+/**
+ * \fn network_sock_status_t NetworkPortSendTo(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const network_endpoint_t *pDst, uint8_t flags)
+ * \brief Queue a message for a remote endpoint, without blocking (descriptor mode only)
+ *
+ * \param portId network port id
+ * \param pBuffer pointer to the message data
+ * \param buffSize message size
+ * \param pDst pointer to the recipient endpoint (NULL: port default recipient, null PortNb: port distant port)
+ * \param flags send flags (NETWORK_MSG_DONTROUTE)
+ * \return network_sock_status_t: NETWORK_SOCK_OK if queued
+ */
+network_sock_status_t NetworkPortSendTo(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const network_endpoint_t *pDst, uint8_t flags);
+
+/**
+ * \fn network_sock_status_t NetworkPortRecvFrom(uint8_t portId, uint8_t *pBuffer, uint16_t buffSize, uint16_t *pDataSize, network_endpoint_t *pSrc, uint8_t flags)
+ * \brief Read the next received message and its sender endpoint, without blocking (descriptor mode only)
+ *
+ * \param portId network port id
+ * \param pBuffer pointer to the receive buffer
+ * \param buffSize receive buffer size
+ * \param pDataSize pointer to contain the read data size
+ * \param pSrc pointer to contain the sender endpoint (optional)
+ * \param flags receive flags (NETWORK_MSG_PEEK, NETWORK_MSG_TRUNC)
+ * \return network_sock_status_t: NETWORK_SOCK_OK if read
+ */
+network_sock_status_t NetworkPortRecvFrom(uint8_t portId, uint8_t *pBuffer, uint16_t buffSize, uint16_t *pDataSize, network_endpoint_t *pSrc, uint8_t flags);
+
+/**
+ * \fn uint16_t NetworkPortReadBatch(uint8_t portId, network_msg_entry_t *pEntries, uint16_t entryNb)
+ * \brief Read several received messages at once, one per entry (descriptor mode only)
+ *
+ * Reading stops at the first message larger than its entry buffer, this message is left in the port.
+ *
+ * \param portId network port id
+ * \param pEntries pointer to the message entries, buffers and buffer sizes to set by the caller
+ * \param entryNb entry nb
+ * \return uint16_t: read message nb
+ */
+uint16_t NetworkPortReadBatch(uint8_t portId, network_msg_entry_t *pEntries, uint16_t entryNb);
+
+/**
+ * \fn bool NetworkPortSendBatch(uint8_t portId, const network_msg_entry_t *pEntries, uint16_t entryNb)
+ * \brief Queue several messages at once, the whole batch is sent in the next tx pass (descriptor mode only)
+ *
+ * \param portId network port id
+ * \param pEntries pointer to the message entries (buffer, message size and recipient endpoint)
+ * \param entryNb entry nb
+ * \return bool: true if all messages were queued, false if none was
+ */
+bool NetworkPortSendBatch(uint8_t portId, const network_msg_entry_t *pEntries, uint16_t entryNb);
+
+/**
+ * \fn bool NetworkPortRecvPeek(uint8_t portId, network_sg_entry_t *pSpans, network_endpoint_t *pSrc)
+ * \brief Get the next received message in place, without copying nor consuming it (descriptor mode only)
+ *
+ * The message is split in two spans when it rolls over the end of the port fifo.
+ * The spans stay valid until the message is released with NetworkPortRecvRelease.
+ *
+ * \param portId network port id
+ * \param pSpans pointer to an array of 2 spans to fill (the second one is empty unless the message rolls over)
+ * \param pSrc pointer to contain the sender endpoint (optional)
+ * \return bool: true if a message is available
+ */
+bool NetworkPortRecvPeek(uint8_t portId, network_sg_entry_t *pSpans, network_endpoint_t *pSrc);
+
+/**
+ * \fn bool NetworkPortRecvRelease(uint8_t portId)
+ * \brief Consume the next received message, after it was processed in place (see NetworkPortRecvPeek)
+ *
+ * \param portId network port id
+ * \return bool: true if a message was consumed
+ */
+bool NetworkPortRecvRelease(uint8_t portId);
+
+/**
+ * \fn bool NetworkPortSendNow(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const uint8_t *pIpDest)
+ * \brief Send a buffer at once, without waiting for the next tx pass
+ *
+ * The datagram is sent synchronously if the port has nothing queued, the recipient arp entry is valid and the message
+ * fits in one datagram (aggregating ports excepted). It is queued as with NetworkPortSendBuff otherwise, when the mac
+ * fails to send it, or when called from a port rx callback (the module buffer still holds the received frame).
+ *
+ * \param portId network port id
+ * \param pBuffer pointer to the buffer to send
+ * \param buffSize buffer size
+ * \param pIpDest recipient ip address (optional)
+ * \return bool: true if sent or queued
+ */
+bool NetworkPortSendNow(uint8_t portId, const uint8_t *pBuffer, uint16_t buffSize, const uint8_t *pIpDest);
+
 // *** End Definitions ***
 #endif // _network_h
\ No newline at end of file
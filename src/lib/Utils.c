@@ -21,6 +21,12 @@
 
 // *** Libraries include ***
 // Standard lib
+#include <string.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 // Custom lib
 #include <Utils.h>
 
@@ -28,11 +34,67 @@
 // --- Private Types ---
 // --- Private Constants ---
 // --- Private Function Prototypes ---
+static uint64_t UtilsInetSumNative(const uint8_t *pData, uint32_t size);
 // --- Private Variables ---
 // *** End Definitions ***
 
 // *** Private Functions ***
 
+/**
+ * \fn static uint64_t UtilsInetSumNative(const uint8_t *pData, uint32_t size)
+ * \brief Sum data as native order 32 bits words in a 64 bits accumulator
+ *
+ * One's complement sums do not depend on word size and byte order, the caller folds and swaps the result.
+ * The vector path is chosen at build time, remaining bytes (size % 4) are not summed.
+ *
+ * \param pData pointer to the data
+ * \param size data size
+ * \return uint64_t: unfolded sum
+ */
+static uint64_t UtilsInetSumNative(const uint8_t *pData, uint32_t size) {
+    uint64_t sum = 0;
+    uint32_t word;
+
+#if defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+    const __m256i zero = _mm256_setzero_si256();
+    uint64_t lanes[4];
+
+    for (; size >= 32; size -= 32, pData += 32) {
+        __m256i data = _mm256_loadu_si256((const __m256i *)pData);
+        acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(data, zero));
+        acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(data, zero));
+    }
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__SSE2__)
+    __m128i acc = _mm_setzero_si128();
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t lanes[2];
+
+    for (; size >= 16; size -= 16, pData += 16) {
+        __m128i data = _mm_loadu_si128((const __m128i *)pData);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(data, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(data, zero));
+    }
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    sum = lanes[0] + lanes[1];
+#elif defined(__ARM_NEON)
+    uint64x2_t acc = vdupq_n_u64(0);
+
+    for (; size >= 16; size -= 16, pData += 16) {
+        acc = vpadalq_u32(acc, vreinterpretq_u32_u8(vld1q_u8(pData)));
+    }
+    sum = vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1);
+#endif
+    // Scalar path and vector leftovers
+    for (; size >= 4; size -= 4, pData += 4) {
+        memcpy(&word, pData, sizeof(word));
+        sum += word;
+    }
+    return sum;
+}
+
 // *** Public Functions ***
 
 inline uint32_t UtilsRotrUint32(uint32_t n, uint8_t c) {
@@ -57,4 +119,44 @@ inline uint16_t UtilsDiffUint16(uint16_t old, uint16_t cur) {
     } else {
         return (0x0000FFFF - (old - cur));
     }
+}
+
+uint16_t UtilsInetFold(uint64_t sum) {
+    while ((sum >> 16) != 0) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return (uint16_t)sum;
+}
+
+uint16_t UtilsInetSum(const uint8_t *pData, uint32_t size, uint16_t sum) {
+    uint32_t tailSize = size % 4;
+    uint16_t nativeSum = UtilsInetFold(UtilsInetSumNative(pData, size - tailSize));
+    uint32_t result = sum;
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    result += nativeSum;
+#else
+    result += SWAP16(nativeSum);
+#endif
+    // Remaining bytes as big endian words
+    pData += size - tailSize;
+    if (tailSize >= 2) {
+        result += ((uint32_t)pData[0] << 8) | pData[1];
+        pData += 2;
+        tailSize -= 2;
+    }
+    if (tailSize > 0) {
+        result += (uint32_t)pData[0] << 8;
+    }
+    return UtilsInetFold(result);
+}
+
+uint16_t UtilsInetChecksum(const uint8_t *pData, uint32_t size) {
+    return (uint16_t)~UtilsInetSum(pData, size, 0);
+}
+
+uint16_t UtilsInetChecksumUpdate(uint16_t checksum, uint16_t oldWord, uint16_t newWord) {
+    uint32_t sum = (uint32_t)(uint16_t)(~checksum) + (uint16_t)(~oldWord) + newWord;
+
+    return (uint16_t)~UtilsInetFold(sum);
 }
\ No newline at end of file
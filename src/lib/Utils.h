@@ -76,5 +76,50 @@ uint32_t UtilsDiffUint32(uint32_t old, uint32_t cur);
  */
 uint16_t UtilsDiffUint16(uint16_t old, uint16_t cur);
 
+/**
+ * \fn uint16_t UtilsInetFold(uint64_t sum)
+ * \brief Fold a one's complement sum on 16 bits (end-around carries included)
+ *
+ * \param sum one's complement sum
+ * \return uint16_t: folded sum
+ */
+uint16_t UtilsInetFold(uint64_t sum);
+
+/**
+ * \fn uint16_t UtilsInetSum(const uint8_t *pData, uint32_t size, uint16_t sum)
+ * \brief Add data to an internet one's complement sum of big endian words
+ *
+ * Data must start at an even position of the summed area, an odd trailing byte is the high part of a word.
+ *
+ * \param pData pointer to the data (no alignment required)
+ * \param size data size
+ * \param sum folded sum to add the data to
+ * \return uint16_t: folded sum (host order)
+ */
+uint16_t UtilsInetSum(const uint8_t *pData, uint32_t size, uint16_t sum);
+
+/**
+ * \fn uint16_t UtilsInetChecksum(const uint8_t *pData, uint32_t size)
+ * \brief Returns the internet checksum of data (RFC 1071)
+ *
+ * \param pData pointer to the data (no alignment required)
+ * \param size data size
+ * \return uint16_t: checksum (host order), 0 when computed over data with a valid checksum
+ */
+uint16_t UtilsInetChecksum(const uint8_t *pData, uint32_t size);
+
+/**
+ * \fn uint16_t UtilsInetChecksumUpdate(uint16_t checksum, uint16_t oldWord, uint16_t newWord)
+ * \brief Returns an internet checksum updated for a modified word (RFC 1624)
+ *
+ * Checksum and words only need to share the same byte order.
+ *
+ * \param checksum previous checksum
+ * \param oldWord previous word value
+ * \param newWord new word value
+ * \return uint16_t: updated checksum
+ */
+uint16_t UtilsInetChecksumUpdate(uint16_t checksum, uint16_t oldWord, uint16_t newWord);
+
 // *** End Definitions ***
 #endif // _Utils_h
\ No newline at end of file
@@ -92,4 +92,52 @@ void test_fifo_read_write(void) {
 	TEST_ASSERT_TRUE(FifoRead(pTestFifo, &read_array, sizeof(read_array), true));
 	TEST_ASSERT_EQUAL_INT(memcmp(write_array, read_array, sizeof(write_array)), 0);
 	TEST_ASSERT_EQUAL_INT(0, FifoItemCount(pTestFifo));
-}
\ No newline at end of file
+}
+
+void test_fifo_peek(void) {
+	uint8_t write_array[FIFO_SIZE];
+	uint8_t read_array[FIFO_SIZE];
+	for (uint8_t idx = 0; idx < FIFO_SIZE; idx++) {
+		write_array[idx] = (uint8_t)rand();
+	}
+	// Move the read idx to force a roll-over
+	TEST_ASSERT_TRUE(FifoWrite(pTestFifo, write_array, FIFO_SIZE / 2));
+	TEST_ASSERT_TRUE(FifoConsume(pTestFifo, FIFO_SIZE / 2));
+	TEST_ASSERT_TRUE(FifoWrite(pTestFifo, write_array, FIFO_SIZE));
+	// Peek across the roll-over without consuming
+	TEST_ASSERT_TRUE(FifoPeek(pTestFifo, read_array, FIFO_SIZE / 4, FIFO_SIZE / 2));
+	TEST_ASSERT_EQUAL_INT(0, memcmp(&write_array[FIFO_SIZE / 4], read_array, FIFO_SIZE / 2));
+	TEST_ASSERT_TRUE(FifoPeek(pTestFifo, read_array, FIFO_SIZE / 2 + 10, FIFO_SIZE / 2 - 10));
+	TEST_ASSERT_EQUAL_INT(0, memcmp(&write_array[FIFO_SIZE / 2 + 10], read_array, FIFO_SIZE / 2 - 10));
+	TEST_ASSERT_EQUAL_INT(FIFO_SIZE, FifoItemCount(pTestFifo));
+	// Can't peek past the written data
+	TEST_ASSERT_FALSE(FifoPeek(pTestFifo, read_array, 1, FIFO_SIZE));
+}
+
+void test_fifo_spans(void) {
+	uint8_t write_array[FIFO_SIZE];
+	uint8_t read_array[FIFO_SIZE];
+	fifo_span_t spans[2];
+	for (uint8_t idx = 0; idx < FIFO_SIZE; idx++) {
+		write_array[idx] = (uint8_t)rand();
+	}
+	// Move the write idx to force a roll-over
+	TEST_ASSERT_TRUE(FifoWrite(pTestFifo, write_array, FIFO_SIZE / 2));
+	TEST_ASSERT_TRUE(FifoConsume(pTestFifo, FIFO_SIZE / 2));
+	// Write in place across the roll-over
+	TEST_ASSERT_FALSE(FifoGetWriteSpans(pTestFifo, FIFO_SIZE + 1, spans));
+	TEST_ASSERT_TRUE(FifoGetWriteSpans(pTestFifo, FIFO_SIZE, spans));
+	TEST_ASSERT_EQUAL_INT(FIFO_SIZE, spans[0].ItemNb + spans[1].ItemNb);
+	memcpy(spans[0].pData, write_array, spans[0].ItemNb);
+	memcpy(spans[1].pData, &write_array[spans[0].ItemNb], spans[1].ItemNb);
+	TEST_ASSERT_EQUAL_INT(0, FifoItemCount(pTestFifo));
+	TEST_ASSERT_TRUE(FifoCommit(pTestFifo, FIFO_SIZE));
+	TEST_ASSERT_EQUAL_INT(FIFO_SIZE, FifoItemCount(pTestFifo));
+	// Read in place past an offset
+	TEST_ASSERT_TRUE(FifoGetReadSpans(pTestFifo, 10, FIFO_SIZE - 10, spans));
+	memcpy(read_array, spans[0].pData, spans[0].ItemNb);
+	memcpy(&read_array[spans[0].ItemNb], spans[1].pData, spans[1].ItemNb);
+	TEST_ASSERT_EQUAL_INT(0, memcmp(&write_array[10], read_array, FIFO_SIZE - 10));
+	TEST_ASSERT_FALSE(FifoGetReadSpans(pTestFifo, 1, FIFO_SIZE, spans));
+	TEST_ASSERT_FALSE(FifoCommit(pTestFifo, 1));
+}
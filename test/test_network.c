@@ -46,12 +46,79 @@ static const network_ctrl_desc_t NetworkMainCtrlDesc = {
         (network_mac_ctrl_has_msg_ft*)MacCtrlHasData,
         (network_mac_ctrl_get_msg_ft*)MacCtrlGetData,
         (network_mac_ctrl_send_msg_ft*)MacCtrlSendData,
+        NETWORK_CAP_TX_IPV4_CKSUM | NETWORK_CAP_RX_IPV4_CKSUM, // Mac offloads
     },
     {0x01, 0x23, 0x45, 0x67, 0x89, 0xab}, // Controller mac address
     {192, 168, 2, 101}, // Controller ip address
     {255, 255, 255, 0}, // Controller subnet mask
     MAIN_MAC_CTRL, // Mac controller id
     20, // Arp table size
+    2, // Ip reassembly context nb
+    4096, // Ip reassembly max size (bytes)
+    0, // Mtu (bytes)
+    2, // Ip alias nb
+    2, // Route nb
+    4, // Multicast group nb
+};
+
+static const network_ctrl_desc_t NetworkJumboCtrlDesc = {
+    {
+        (network_mac_ctrl_set_mac_addr_ft *)MacCtrlSetMacAddress,
+        (network_mac_ctrl_has_msg_ft*)MacCtrlHasData,
+        (network_mac_ctrl_get_msg_ft*)MacCtrlGetData,
+        (network_mac_ctrl_send_msg_ft*)MacCtrlSendData,
+        NETWORK_CAP_TX_IPV4_CKSUM | NETWORK_CAP_RX_IPV4_CKSUM, // Mac offloads
+    },
+    {0x01, 0x23, 0x45, 0x67, 0x89, 0xab}, // Controller mac address
+    {192, 168, 2, 101}, // Controller ip address
+    {255, 255, 255, 0}, // Controller subnet mask
+    MAIN_MAC_CTRL, // Mac controller id
+    20, // Arp table size
+    0, // Ip reassembly context nb
+    0, // Ip reassembly max size (bytes)
+    ETHERNET_JUMBO_PAYLOAD_SIZE, // Mtu (bytes)
+};
+
+static const network_ctrl_desc_t NetworkSwChecksumCtrlDesc = {
+    {
+        (network_mac_ctrl_set_mac_addr_ft *)MacCtrlSetMacAddress,
+        (network_mac_ctrl_has_msg_ft*)MacCtrlHasData,
+        (network_mac_ctrl_get_msg_ft*)MacCtrlGetData,
+        (network_mac_ctrl_send_msg_ft*)MacCtrlSendData,
+        0, // Mac offloads
+    },
+    {0x01, 0x23, 0x45, 0x67, 0x89, 0xab}, // Controller mac address
+    {192, 168, 2, 101}, // Controller ip address
+    {255, 255, 255, 0}, // Controller subnet mask
+    MAIN_MAC_CTRL, // Mac controller id
+    20, // Arp table size
+    0, // Ip reassembly context nb
+    0, // Ip reassembly max size (bytes)
+    0, // Mtu (bytes)
+};
+
+static bool gather_send_Callback(uint8_t macId, const network_sg_entry_t *pEntries, uint8_t entryNb);
+static bool port_rx_Callback(uint8_t portId, const uint8_t *pData, uint16_t dataSize, const network_endpoint_t *pSrc);
+static bool close_rx_Callback(uint8_t portId, const uint8_t *pData, uint16_t dataSize, const network_endpoint_t *pSrc);
+
+static const network_ctrl_desc_t NetworkOffloadCtrlDesc = {
+    {
+        (network_mac_ctrl_set_mac_addr_ft *)MacCtrlSetMacAddress,
+        (network_mac_ctrl_has_msg_ft*)MacCtrlHasData,
+        (network_mac_ctrl_get_msg_ft*)MacCtrlGetData,
+        (network_mac_ctrl_send_msg_ft*)MacCtrlSendData,
+        NETWORK_CAP_TX_IPV4_CKSUM | NETWORK_CAP_RX_IPV4_CKSUM | NETWORK_CAP_TX_UDP_CKSUM | NETWORK_CAP_RX_UDP_CKSUM
+            | NETWORK_CAP_TX_SEGMENT | NETWORK_CAP_SCATTER_GATHER, // Mac offloads
+        gather_send_Callback, // Mac gathered send
+    },
+    {0x01, 0x23, 0x45, 0x67, 0x89, 0xab}, // Controller mac address
+    {192, 168, 2, 101}, // Controller ip address
+    {255, 255, 255, 0}, // Controller subnet mask
+    MAIN_MAC_CTRL, // Mac controller id
+    20, // Arp table size
+    2, // Ip reassembly context nb
+    4096, // Ip reassembly max size (bytes)
+    0, // Mtu (bytes)
 };
 
 static const network_port_desc_t NetworkMainPortDesc = {
@@ -78,18 +145,257 @@ static const network_port_desc_t NetworkSecPortDesc = {
     0, // Mode virtual port com
 };
 
+static const network_port_desc_t NetworkCtrlPortDesc = {
+    MAIN_NETWORK_CTRL, // Network controller id
+    IP_PROT_UDP, // Network protocol
+    {192, 168, 2, 0}, // Default recipient ip address
+    10301, // Local network port nb
+    10401, // Distant network port nb
+    1 * ETHERNET_FRAME_LENTGH_MAX, // Rx fifo size (bytes)
+    20, // Rx descriptor fifo size (message nb)
+    1 * ETHERNET_FRAME_LENTGH_MAX, // Tx fifo size (bytes)
+    20, // Tx descriptor fifo size (message nb)
+    NETWORK_PRIO_CONTROL, // Tx priority class
+};
+
+static const network_port_desc_t NetworkShapedPortDesc = {
+    MAIN_NETWORK_CTRL, // Network controller id
+    IP_PROT_UDP, // Network protocol
+    {192, 168, 2, 0}, // Default recipient ip address
+    10501, // Local network port nb
+    10601, // Distant network port nb
+    1 * ETHERNET_FRAME_LENTGH_MAX, // Rx fifo size (bytes)
+    20, // Rx descriptor fifo size (message nb)
+    1 * ETHERNET_FRAME_LENTGH_MAX, // Tx fifo size (bytes)
+    20, // Tx descriptor fifo size (message nb)
+    NETWORK_PRIO_BEST_EFFORT, // Tx priority class
+    1000, // Tx rate limit (bytes/s)
+    100, // Tx burst size (bytes)
+};
+
+static const network_port_desc_t NetworkCoalescePortDesc = {
+    MAIN_NETWORK_CTRL, // Network controller id
+    IP_PROT_UDP, // Network protocol
+    {192, 168, 2, 0}, // Default recipient ip address
+    25565, // Local network port nb
+    25565, // Distant network port nb
+    1 * ETHERNET_FRAME_LENTGH_MAX, // Rx fifo size (bytes)
+    0, // Mode virtual port com
+    1 * ETHERNET_FRAME_LENTGH_MAX, // Tx fifo size (bytes)
+    0, // Mode virtual port com
+    NETWORK_PRIO_BEST_EFFORT, // Tx priority class
+    0, // Tx rate limit (bytes/s)
+    0, // Tx burst size (bytes)
+    8, // Tx coalesce size (bytes)
+    5, // Tx coalesce delay (ms)
+};
+
+static const network_port_desc_t NetworkAggregatePortDesc = {
+    MAIN_NETWORK_CTRL, // Network controller id
+    IP_PROT_UDP, // Network protocol
+    {192, 168, 2, 0}, // Default recipient ip address
+    10701, // Local network port nb
+    10701, // Distant network port nb
+    1 * ETHERNET_FRAME_LENTGH_MAX, // Rx fifo size (bytes)
+    8, // Rx descriptor nb
+    1 * ETHERNET_FRAME_LENTGH_MAX, // Tx fifo size (bytes)
+    8, // Tx descriptor nb
+    NETWORK_PRIO_BEST_EFFORT, // Tx priority class
+    0, // Tx rate limit (bytes/s)
+    0, // Tx burst size (bytes)
+    0, // Tx coalesce size (bytes)
+    0, // Tx coalesce delay (ms)
+    NETWORK_PORT_OPT_AGGREGATE, // Port options
+};
+
+static const network_port_desc_t NetworkSegmentPortDesc = {
+    MAIN_NETWORK_CTRL, // Network controller id
+    IP_PROT_UDP, // Network protocol
+    {192, 168, 2, 0}, // Default recipient ip address
+    10801, // Local network port nb
+    10901, // Distant network port nb
+    1 * ETHERNET_FRAME_LENTGH_MAX, // Rx fifo size (bytes)
+    4, // Rx descriptor nb
+    4096, // Tx fifo size (bytes)
+    4, // Tx descriptor nb
+    NETWORK_PRIO_BEST_EFFORT, // Tx priority class
+    0, // Tx rate limit (bytes/s)
+    0, // Tx burst size (bytes)
+    0, // Tx coalesce size (bytes)
+    0, // Tx coalesce delay (ms)
+    NETWORK_PORT_OPT_SEGMENT, // Port options
+};
+
+static const network_port_desc_t NetworkFragmentPortDesc = {
+    MAIN_NETWORK_CTRL, // Network controller id
+    IP_PROT_UDP, // Network protocol
+    {192, 168, 2, 0}, // Default recipient ip address
+    11001, // Local network port nb
+    11101, // Distant network port nb
+    1 * ETHERNET_FRAME_LENTGH_MAX, // Rx fifo size (bytes)
+    4, // Rx descriptor nb
+    4096, // Tx fifo size (bytes)
+    4, // Tx descriptor nb
+    NETWORK_PRIO_BEST_EFFORT, // Tx priority class
+    0, // Tx rate limit (bytes/s)
+    0, // Tx burst size (bytes)
+    0, // Tx coalesce size (bytes)
+    0, // Tx coalesce delay (ms)
+    NETWORK_PORT_OPT_FRAGMENT, // Port options
+};
+
+static const network_port_desc_t NetworkReasmPortDesc = {
+    MAIN_NETWORK_CTRL, // Network controller id
+    IP_PROT_UDP, // Network protocol
+    {192, 168, 2, 0}, // Default recipient ip address
+    11201, // Local network port nb
+    11201, // Distant network port nb
+    4096, // Rx fifo size (bytes)
+    4, // Rx descriptor nb
+    4096, // Tx fifo size (bytes)
+    4, // Tx descriptor nb
+    NETWORK_PRIO_BEST_EFFORT, // Tx priority class
+    0, // Tx rate limit (bytes/s)
+    0, // Tx burst size (bytes)
+    0, // Tx coalesce size (bytes)
+    0, // Tx coalesce delay (ms)
+    NETWORK_PORT_OPT_FRAGMENT, // Port options
+};
+
+static const network_port_desc_t NetworkUdpChecksumPortDesc = {
+    MAIN_NETWORK_CTRL, // Network controller id
+    IP_PROT_UDP, // Network protocol
+    {192, 168, 2, 0}, // Default recipient ip address
+    11301, // Local network port nb
+    11301, // Distant network port nb
+    4096, // Rx fifo size (bytes)
+    4, // Rx descriptor nb
+    4096, // Tx fifo size (bytes)
+    4, // Tx descriptor nb
+    NETWORK_PRIO_BEST_EFFORT, // Tx priority class
+    0, // Tx rate limit (bytes/s)
+    0, // Tx burst size (bytes)
+    0, // Tx coalesce size (bytes)
+    0, // Tx coalesce delay (ms)
+    NETWORK_PORT_OPT_FRAGMENT | NETWORK_PORT_OPT_UDP_CKSUM, // Port options
+};
+
+static const network_port_desc_t NetworkReusePortDesc = {
+    MAIN_NETWORK_CTRL, // Network controller id
+    IP_PROT_UDP, // Network protocol
+    {192, 168, 2, 0}, // Default recipient ip address
+    25565, // Local network port nb
+    25565, // Distant network port nb
+    1024, // Rx fifo size (bytes)
+    16, // Rx descriptor nb
+    1024, // Tx fifo size (bytes)
+    4, // Tx descriptor nb
+    NETWORK_PRIO_BEST_EFFORT, // Tx priority class
+    0, // Tx rate limit (bytes/s)
+    0, // Tx burst size (bytes)
+    0, // Tx coalesce size (bytes)
+    0, // Tx coalesce delay (ms)
+    NETWORK_PORT_OPT_REUSEPORT, // Port options
+};
+
+static const network_port_desc_t NetworkConnectedPortDesc = {
+    MAIN_NETWORK_CTRL, // Network controller id
+    IP_PROT_UDP, // Network protocol
+    {192, 168, 2, 16}, // Default recipient ip address
+    25565, // Local network port nb
+    25565, // Distant network port nb
+    1024, // Rx fifo size (bytes)
+    4, // Rx descriptor nb
+    1024, // Tx fifo size (bytes)
+    4, // Tx descriptor nb
+    NETWORK_PRIO_BEST_EFFORT, // Tx priority class
+    0, // Tx rate limit (bytes/s)
+    0, // Tx burst size (bytes)
+    0, // Tx coalesce size (bytes)
+    0, // Tx coalesce delay (ms)
+    NETWORK_PORT_OPT_CONNECTED, // Port options
+};
+
+static const network_port_desc_t NetworkEphemeralPortDesc = {
+    MAIN_NETWORK_CTRL, // Network controller id
+    IP_PROT_UDP, // Network protocol
+    {192, 168, 2, 16}, // Default recipient ip address
+    0, // Local network port nb
+    25565, // Distant network port nb
+    512, // Rx fifo size (bytes)
+    4, // Rx descriptor nb
+    512, // Tx fifo size (bytes)
+    4, // Tx descriptor nb
+    NETWORK_PRIO_BEST_EFFORT, // Tx priority class
+    0, // Tx rate limit (bytes/s)
+    0, // Tx burst size (bytes)
+    0, // Tx coalesce size (bytes)
+    0, // Tx coalesce delay (ms)
+    0, // Port options
+};
+
+static const network_port_desc_t NetworkCallbackPortDesc = {
+    MAIN_NETWORK_CTRL, // Network controller id
+    IP_PROT_UDP, // Network protocol
+    {192, 168, 2, 16}, // Default recipient ip address
+    25565, // Local network port nb
+    25565, // Distant network port nb
+    512, // Rx fifo size (bytes)
+    4, // Rx descriptor nb
+    512, // Tx fifo size (bytes)
+    4, // Tx descriptor nb
+    NETWORK_PRIO_BEST_EFFORT, // Tx priority class
+    0, // Tx rate limit (bytes/s)
+    0, // Tx burst size (bytes)
+    0, // Tx coalesce size (bytes)
+    0, // Tx coalesce delay (ms)
+    0, // Port options
+    port_rx_Callback, // Rx callback
+};
+
+static const network_port_desc_t NetworkClosingPortDesc = {
+    MAIN_NETWORK_CTRL, // Network controller id
+    IP_PROT_UDP, // Network protocol
+    {192, 168, 2, 0}, // Default recipient ip address
+    11401, // Local network port nb
+    11401, // Distant network port nb
+    512, // Rx fifo size (bytes)
+    4, // Rx descriptor nb
+    512, // Tx fifo size (bytes)
+    4, // Tx descriptor nb
+    NETWORK_PRIO_BEST_EFFORT, // Tx priority class
+    0, // Tx rate limit (bytes/s)
+    0, // Tx burst size (bytes)
+    0, // Tx coalesce size (bytes)
+    0, // Tx coalesce delay (ms)
+    NETWORK_PORT_OPT_AGGREGATE | NETWORK_PORT_OPT_UDP_CKSUM, // Port options
+    close_rx_Callback, // Rx callback
+};
+
 
 
 // *** Private global vars ***
 static bool init_srand;
 static void *memPtr[64];
 static int memIdx;
-static uint8_t in_buffer[ETHERNET_FRAME_LENTGH_MAX];
-static uint8_t in_buff_size;
-static uint8_t out_buffer[ETHERNET_FRAME_LENTGH_MAX];
-static uint8_t out_buff_size;
+static uint8_t in_buffer[ETHERNET_JUMBO_PAYLOAD_SIZE + ETH_HEADER_SIZE];
+static uint16_t in_buff_size;
+static uint8_t out_buffer[ETHERNET_JUMBO_PAYLOAD_SIZE + ETH_HEADER_SIZE];
+static uint16_t out_buff_size;
 static bool hasData;
 static uint32_t timeVal;
+static uint8_t sent_tos[8];
+static uint16_t sent_ports[8];
+static uint16_t sent_sizes[8];
+static uint16_t sent_ids[8];
+static uint16_t sent_frags[8];
+static int sent_nb;
+static int rx_cb_nb;
+static bool rx_cb_consume;
+static uint8_t rx_cb_data[64];
+static uint16_t rx_cb_size;
+static network_endpoint_t rx_cb_src;
+static uint8_t sent_frames[3][ETHERNET_FRAME_LENTGH_MAX];
 
 
 
@@ -219,6 +525,83 @@ static bool send_data_Callback(uint8_t macId, const uint8_t *pBuffer, uint16_t b
     return true;
 }
 
+static bool record_send_Callback(uint8_t macId, const uint8_t *pBuffer, uint16_t buffSize, int num_calls) {
+    if (sent_nb < 8) {
+        sent_tos[sent_nb] = pBuffer[15];
+        sent_ports[sent_nb] = (uint16_t)((pBuffer[34] << 8) | pBuffer[35]);
+        sent_sizes[sent_nb] = buffSize;
+        sent_ids[sent_nb] = (uint16_t)((pBuffer[18] << 8) | pBuffer[19]);
+        sent_frags[sent_nb] = (uint16_t)((pBuffer[20] << 8) | pBuffer[21]);
+        sent_nb++;
+    }
+    return send_data_Callback(macId, pBuffer, buffSize, num_calls);
+}
+
+static bool busy_send_Callback(uint8_t macId, const uint8_t *pBuffer, uint16_t buffSize, int num_calls) {
+    return false;
+}
+
+static bool capture_send_Callback(uint8_t macId, const uint8_t *pBuffer, uint16_t buffSize, int num_calls) {
+    if (sent_nb < 3) {
+        memcpy(sent_frames[sent_nb], pBuffer, buffSize);
+    }
+    return record_send_Callback(macId, pBuffer, buffSize, num_calls);
+}
+
+static bool gather_send_Callback(uint8_t macId, const network_sg_entry_t *pEntries, uint8_t entryNb) {
+    out_buff_size = 0;
+    for (uint8_t idx = 0; idx < entryNb; idx++) {
+        memcpy(out_buffer + out_buff_size, pEntries[idx].pData, pEntries[idx].Size);
+        out_buff_size += pEntries[idx].Size;
+    }
+    sent_nb++;
+    return true;
+}
+
+static void loop_frame_back(const uint8_t *pFrame, uint16_t frameSize) {
+    const uint8_t ctrlMac[6] = {0x01, 0x23, 0x45, 0x67, 0x89, 0xab};
+    const uint8_t ctrlIp[4] = {192, 168, 2, 101};
+
+    // Swap addresses as if the frame was sent by 192.168.2.0
+    in_buff_size = frameSize;
+    memcpy(in_buffer, pFrame, in_buff_size);
+    memcpy(in_buffer + 6, in_buffer, 6);
+    memcpy(in_buffer, ctrlMac, sizeof(ctrlMac));
+    memcpy(in_buffer + 26, in_buffer + 30, 4);
+    memcpy(in_buffer + 30, ctrlIp, sizeof(ctrlIp));
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+}
+
+static bool port_rx_Callback(uint8_t portId, const uint8_t *pData, uint16_t dataSize, const network_endpoint_t *pSrc) {
+    rx_cb_nb++;
+    rx_cb_size = dataSize;
+    memcpy(rx_cb_data, pData, dataSize);
+    rx_cb_src = *pSrc;
+    // Immediate answer is queued while the rx frame is processed
+    TEST_ASSERT_TRUE(NetworkPortSendNow(portId, pData, dataSize, pSrc->IpAddr));
+    return rx_cb_consume;
+}
+
+static bool close_rx_Callback(uint8_t portId, const uint8_t *pData, uint16_t dataSize, const network_endpoint_t *pSrc) {
+    rx_cb_nb++;
+    TEST_ASSERT_TRUE(NetworkPortClose(portId));
+    return false;
+}
+
+static uint16_t ip_header_sum(const uint8_t *pFrame) {
+    uint32_t sum = 0;
+
+    for (uint8_t idx = 0; idx < IPV4_HEADER_SIZE; idx += 2) {
+        sum += (uint32_t)((pFrame[ETH_HEADER_SIZE + idx] << 8) | pFrame[ETH_HEADER_SIZE + idx + 1]);
+    }
+    while ((sum >> 16) != 0) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return (uint16_t)sum;
+}
+
 static uint32_t time_get_Callback(int num_calls) {
     return timeVal;
 }
@@ -337,7 +720,7 @@ static void udp_tests(void) {
     
     // *** UDP TESTS RX ***
     uint16_t received_size;
-    uint8_t received_array[64];
+    uint8_t received_array[64] = {0};
     uint8_t source_ip[4];
     const char modelStr[] = "Syneresis";
     // Recieve data
@@ -416,6 +799,11 @@ void test_network_parameters(void) {
     TEST_ASSERT_EQUAL_UINT8_ARRAY(newCtrlSubnetMsk, NetworkCtrlGetSubnetMask(MAIN_NETWORK_CTRL), 4) ;
     TEST_ASSERT_EQUAL_UINT8_ARRAY(newCtrlIpAdr, NetworkCtrlGetIpAddress(MAIN_NETWORK_CTRL), 4);
     TEST_ASSERT_EQUAL_UINT8_ARRAY(newCtrlMacAdr, NetworkCtrlGetMacAddr(MAIN_NETWORK_CTRL), 6);    
+    // Destination checks follow the new subnet
+    uint8_t widerSubnetIpAdr[4] = {192, 168, 3, 10};
+    uint8_t otherSubnetIpAdr[4] = {192, 168, 4, 10};
+    TEST_ASSERT_TRUE(NetworkPortSetDstIpAddress(MAIN_NETWORK_PORT, widerSubnetIpAdr));
+    TEST_ASSERT_FALSE(NetworkPortSetDstIpAddress(MAIN_NETWORK_PORT, otherSubnetIpAdr));
 }
 
 void test_network_packets(void) {
@@ -439,7 +827,7 @@ void test_network_packets(void) {
 void test_network_virtual_port_com(void) {
     const char modelStr[] = "Hessian matrix";
     uint16_t received_size;
-    uint8_t received_array[64];
+    uint8_t received_array[64] = {0};
     
     // Mac_ctrl spoofing
     MacCtrlHasData_StubWithCallback(has_data_Callback);
@@ -470,4 +858,1377 @@ void test_network_virtual_port_com(void) {
     TEST_ASSERT_EQUAL_INT(0, strcmp(modelStr, (char *)received_array));
     TEST_ASSERT_EQUAL_INT(strlen(modelStr), received_size + 1);
     TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(MAIN_NETWORK_PORT));   
-}
\ No newline at end of file
+}
+
+void test_network_tx_priority(void) {
+    uint8_t ipAdr[4] = {192, 168, 2, 0};
+    uint8_t macAdr[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    uint8_t send_array[] = {0, 1, 2, 3};
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlSendData_StubWithCallback(record_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    sent_nb = 0;
+
+    // Add control network port
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkCtrlPortDesc));
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, ipAdr, macAdr, false));
+    // Queue bulk data first, then control data
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(MAIN_NETWORK_PORT, send_array, sizeof(send_array), ipAdr));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(MAIN_NETWORK_PORT, send_array, sizeof(send_array), ipAdr));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    // Control port is drained before the bulk port sends its message
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(3, sent_nb);
+    TEST_ASSERT_EQUAL_INT(10301, sent_ports[0]);
+    TEST_ASSERT_EQUAL_INT(10301, sent_ports[1]);
+    TEST_ASSERT_EQUAL_INT(10101, sent_ports[2]);
+    TEST_ASSERT_TRUE(NetworkPortIsTxEmpty(SEC_NETWORK_PORT));
+    TEST_ASSERT_FALSE(NetworkPortIsTxEmpty(MAIN_NETWORK_PORT));
+    // Dscp marking (CS6 for control, CS0 for best effort)
+    TEST_ASSERT_EQUAL_HEX8(48 << 2, sent_tos[0]);
+    TEST_ASSERT_EQUAL_HEX8(0, sent_tos[2]);
+}
+
+void test_network_tx_shaping(void) {
+    uint8_t ipAdr[4] = {192, 168, 2, 0};
+    uint8_t macAdr[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    uint8_t send_array[10] = {0};
+    network_port_stats_t stats;
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlSendData_StubWithCallback(record_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    sent_nb = 0;
+
+    // Add shaped network port (52 bytes frames, 100 bytes burst, 1 byte/ms)
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkShapedPortDesc));
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, ipAdr, macAdr, false));
+    for (int idx = 0; idx < 3; idx++) {
+        TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    }
+    // First frame goes out of the full bucket, second one is held back
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    TEST_ASSERT_TRUE(NetworkPortGetStats(SEC_NETWORK_PORT, &stats));
+    TEST_ASSERT_EQUAL_INT(1, stats.ShaperHoldNb);
+    // Enough tokens after 4 ms
+    timeVal += 3;
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    timeVal += 1;
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(2, sent_nb);
+    TEST_ASSERT_TRUE(NetworkPortGetStats(SEC_NETWORK_PORT, &stats));
+    TEST_ASSERT_EQUAL_INT(4, stats.ShaperDelay);
+    // Last frame needs a full refill
+    timeVal += 52;
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(3, sent_nb);
+    TEST_ASSERT_TRUE(NetworkPortIsTxEmpty(SEC_NETWORK_PORT));
+}
+
+void test_network_tx_coalesce(void) {
+    uint8_t ipAdr[4] = {192, 168, 2, 0};
+    uint8_t macAdr[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlSendData_StubWithCallback(record_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    sent_nb = 0;
+
+    // Add coalescing virtual com port
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkCoalescePortDesc));
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, ipAdr, macAdr, false));
+    // Bytes are gathered until the coalesce size is reached
+    for (uint8_t idx = 0; idx < 8; idx++) {
+        TEST_ASSERT_TRUE(NetworkPortSendByte(SEC_NETWORK_PORT, idx, NULL));
+        NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    }
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    TEST_ASSERT_EQUAL_INT(NETWORK_HEADER_SIZE + 8, out_buff_size);
+    // Lone byte is sent once the latency bound is reached
+    TEST_ASSERT_TRUE(NetworkPortSendByte(SEC_NETWORK_PORT, 0x55, NULL));
+    timeVal += 4;
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    timeVal += 1;
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(2, sent_nb);
+    TEST_ASSERT_EQUAL_INT(NETWORK_HEADER_SIZE + 1, out_buff_size);
+    TEST_ASSERT_TRUE(NetworkPortIsTxEmpty(SEC_NETWORK_PORT));
+}
+
+void test_network_aggregate(void) {
+    uint8_t ipAdr[4] = {192, 168, 2, 0};
+    uint8_t macAdr[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    uint8_t ctrlIp[4] = {192, 168, 2, 101};
+    uint8_t ctrlMac[6] = {0x01, 0x23, 0x45, 0x67, 0x89, 0xab};
+    uint8_t send_array[] = {0, 1, 2, 3, 4};
+    uint8_t received_array[8];
+    uint16_t received_size;
+    uint8_t source_ip[4];
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlGetData_StubWithCallback(get_data_Callback);
+    MacCtrlSendData_StubWithCallback(record_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    sent_nb = 0;
+
+    // Add aggregating port
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkAggregatePortDesc));
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, ipAdr, macAdr, false));
+    // Queued messages for the same recipient are packed in one datagram
+    TEST_ASSERT_TRUE(NetworkPortSendByte(SEC_NETWORK_PORT, 0x55, NULL));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    TEST_ASSERT_TRUE(NetworkPortSendString(SEC_NETWORK_PORT, "Hi", NULL));
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    TEST_ASSERT_EQUAL_INT(NETWORK_HEADER_SIZE + 14, out_buff_size);
+    const uint8_t modelData[] = {0x00, 0x01, 0x55, 0x00, 0x05, 0, 1, 2, 3, 4, 0x00, 0x02, 'H', 'i'};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(modelData, out_buffer + NETWORK_HEADER_SIZE, sizeof(modelData));
+    TEST_ASSERT_TRUE(NetworkPortIsTxEmpty(SEC_NETWORK_PORT));
+
+    // Loop the datagram back and check it is split on reception
+    memcpy(in_buffer, out_buffer, out_buff_size);
+    in_buff_size = out_buff_size;
+    memcpy(in_buffer, ctrlMac, sizeof(ctrlMac));
+    memcpy(in_buffer + 6, macAdr, sizeof(macAdr));
+    memcpy(in_buffer + 26, ipAdr, sizeof(ipAdr));
+    memcpy(in_buffer + 30, ctrlIp, sizeof(ctrlIp));
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_EQUAL_INT(1, received_size);
+    TEST_ASSERT_EQUAL_HEX8(0x55, received_array[0]);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(ipAdr, source_ip, sizeof(source_ip));
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(send_array, received_array, sizeof(send_array));
+    TEST_ASSERT_EQUAL_INT(sizeof(send_array), received_size);
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_EQUAL_INT(2, received_size);
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+}
+
+void test_network_tx_segment(void) {
+    uint8_t ipAdr[4] = {192, 168, 2, 0};
+    uint8_t macAdr[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    static uint8_t send_array[3000];
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlSendData_StubWithCallback(record_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    sent_nb = 0;
+    for (uint16_t idx = 0; idx < sizeof(send_array); idx++) {
+        send_array[idx] = (uint8_t)idx;
+    }
+
+    // Add segmenting port
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkSegmentPortDesc));
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, ipAdr, macAdr, false));
+    // Large block is stored once
+    TEST_ASSERT_FALSE(NetworkPortSendBuff(MAIN_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    // And sent as max size datagrams
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(3, sent_nb);
+    TEST_ASSERT_EQUAL_INT(NETWORK_HEADER_SIZE + ETHERNET_MAX_DATA_SIZE, sent_sizes[0]);
+    TEST_ASSERT_EQUAL_INT(NETWORK_HEADER_SIZE + ETHERNET_MAX_DATA_SIZE, sent_sizes[1]);
+    TEST_ASSERT_EQUAL_INT(NETWORK_HEADER_SIZE + 56, sent_sizes[2]);
+    TEST_ASSERT_EQUAL_INT(10801, sent_ports[2]);
+    // Last segment lengths and data
+    TEST_ASSERT_EQUAL_HEX8(0, out_buffer[16]);
+    TEST_ASSERT_EQUAL_HEX8(IPV4_HEADER_SIZE + UDP_HEADER_SIZE + 56, out_buffer[17]);
+    TEST_ASSERT_EQUAL_HEX8(0, out_buffer[38]);
+    TEST_ASSERT_EQUAL_HEX8(UDP_HEADER_SIZE + 56, out_buffer[39]);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(send_array + 2 * ETHERNET_MAX_DATA_SIZE, out_buffer + NETWORK_HEADER_SIZE, 56);
+    TEST_ASSERT_TRUE(NetworkPortIsTxEmpty(SEC_NETWORK_PORT));
+}
+
+void test_network_tx_fragment(void) {
+    uint8_t ipAdr[4] = {192, 168, 2, 0};
+    uint8_t macAdr[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    static uint8_t send_array[2000];
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlSendData_StubWithCallback(record_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    sent_nb = 0;
+    for (uint16_t idx = 0; idx < sizeof(send_array); idx++) {
+        send_array[idx] = (uint8_t)idx;
+    }
+
+    // Add fragmenting port
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkFragmentPortDesc));
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, ipAdr, macAdr, false));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    TEST_ASSERT_TRUE(NetworkPortSendByte(SEC_NETWORK_PORT, 0x55, NULL));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    // First datagram: udp header + 1472 bytes, then the remaining 528 bytes at offset 1480
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(2, sent_nb);
+    TEST_ASSERT_EQUAL_INT(NETWORK_HEADER_SIZE + ETHERNET_MAX_DATA_SIZE, sent_sizes[0]);
+    TEST_ASSERT_EQUAL_HEX16(IPV4_FLAG_MF, sent_frags[0]);
+    TEST_ASSERT_EQUAL_INT(ETH_HEADER_SIZE + IPV4_HEADER_SIZE + 528, sent_sizes[1]);
+    TEST_ASSERT_EQUAL_HEX16(IPV4_FRAGMENT_DATA_SIZE / 8, sent_frags[1]);
+    TEST_ASSERT_EQUAL_HEX16(sent_ids[0], sent_ids[1]);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(send_array + ETHERNET_MAX_DATA_SIZE, out_buffer + ETH_HEADER_SIZE + IPV4_HEADER_SIZE, 528);
+    // Atomic datagram keeps the don't fragment flag and no id
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(3, sent_nb);
+    TEST_ASSERT_EQUAL_HEX16(IPV4_FLAG_DF, sent_frags[2]);
+    TEST_ASSERT_EQUAL_HEX16(0, sent_ids[2]);
+    // Next fragmented datagram takes a new id
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(5, sent_nb);
+    TEST_ASSERT_EQUAL_HEX16(sent_ids[0] + 1, sent_ids[3]);
+    TEST_ASSERT_EQUAL_HEX16(sent_ids[3], sent_ids[4]);
+    TEST_ASSERT_TRUE(NetworkPortIsTxEmpty(SEC_NETWORK_PORT));
+}
+
+void test_network_rx_reassembly(void) {
+    uint8_t ipAdr[4] = {192, 168, 2, 0};
+    uint8_t macAdr[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    static uint8_t send_array[3000];
+    static uint8_t received_array[3000];
+    uint16_t received_size;
+    uint8_t source_ip[4];
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlGetData_StubWithCallback(get_data_Callback);
+    MacCtrlSendData_StubWithCallback(capture_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    sent_nb = 0;
+    for (uint16_t idx = 0; idx < sizeof(send_array); idx++) {
+        send_array[idx] = (uint8_t)(idx * 7);
+    }
+
+    // Build the fragments of a 3000 bytes datagram
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkReasmPortDesc));
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, ipAdr, macAdr, false));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(3, sent_nb);
+
+    // Out of order and duplicated fragments are reassembled
+    loop_frame_back(sent_frames[2], sent_sizes[2]);
+    loop_frame_back(sent_frames[0], sent_sizes[0]);
+    loop_frame_back(sent_frames[0], sent_sizes[0]);
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+    loop_frame_back(sent_frames[1], sent_sizes[1]);
+    TEST_ASSERT_FALSE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_EQUAL_INT(sizeof(send_array), received_size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(send_array, received_array, sizeof(send_array));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(ipAdr, source_ip, sizeof(source_ip));
+
+    // Datagrams missing fragments for too long are evicted
+    loop_frame_back(sent_frames[0], sent_sizes[0]);
+    timeVal += 2000;
+    loop_frame_back(sent_frames[1], sent_sizes[1]);
+    loop_frame_back(sent_frames[2], sent_sizes[2]);
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+
+    // Fragments longer than the received frame are dropped
+    timeVal += 2000;
+    loop_frame_back(sent_frames[0], sent_sizes[0] - 100);
+    loop_frame_back(sent_frames[1], sent_sizes[1]);
+    loop_frame_back(sent_frames[2], sent_sizes[2]);
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+    // Fragments with header options are dropped
+    sent_frames[0][14] = 0x46;
+    loop_frame_back(sent_frames[0], sent_sizes[0]);
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+    // Missing fragment completes the datagram
+    sent_frames[0][14] = 0x45;
+    loop_frame_back(sent_frames[0], sent_sizes[0]);
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_EQUAL_INT(sizeof(send_array), received_size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(send_array, received_array, sizeof(send_array));
+
+    // Reassembled datagrams with a udp length beyond their size are dropped
+    sent_frames[0][38] = (uint8_t)((UDP_HEADER_SIZE + sizeof(send_array) + 100) >> 8);
+    sent_frames[0][39] = (uint8_t)(UDP_HEADER_SIZE + sizeof(send_array) + 100);
+    loop_frame_back(sent_frames[0], sent_sizes[0]);
+    loop_frame_back(sent_frames[1], sent_sizes[1]);
+    loop_frame_back(sent_frames[2], sent_sizes[2]);
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+    // Udp lengths shorter than the udp header are dropped
+    sent_frames[0][38] = 0x00;
+    sent_frames[0][39] = 0x04;
+    loop_frame_back(sent_frames[0], sent_sizes[0]);
+    loop_frame_back(sent_frames[1], sent_sizes[1]);
+    loop_frame_back(sent_frames[2], sent_sizes[2]);
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+}
+
+void test_network_jumbo_mtu(void) {
+    uint8_t ipAdr[4] = {192, 168, 2, 0};
+    uint8_t macAdr[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    static uint8_t send_array[4000];
+    static uint8_t received_array[4000];
+    uint16_t received_size;
+    uint8_t source_ip[4];
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlGetData_StubWithCallback(get_data_Callback);
+    MacCtrlSendData_StubWithCallback(record_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    sent_nb = 0;
+    for (uint16_t idx = 0; idx < sizeof(send_array); idx++) {
+        send_array[idx] = (uint8_t)(idx * 3);
+    }
+
+    // Standard mtu limits unfragmented messages
+    TEST_ASSERT_FALSE(NetworkPortSendBuff(MAIN_NETWORK_PORT, send_array, ETHERNET_MAX_DATA_SIZE + 1, NULL));
+    // Jumbo controller
+    TEST_ASSERT_TRUE(NetworkCtrlAdd(MAIN_NETWORK_CTRL, &NetworkJumboCtrlDesc));
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkReasmPortDesc));
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, ipAdr, macAdr, false));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(MAIN_NETWORK_PORT, send_array, ETHERNET_MAX_DATA_SIZE + 1, ipAdr));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    // Message fits in a single frame
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(2, sent_nb);
+    TEST_ASSERT_EQUAL_INT(NETWORK_HEADER_SIZE + ETHERNET_MAX_DATA_SIZE + 1, sent_sizes[0]);
+    TEST_ASSERT_EQUAL_INT(NETWORK_HEADER_SIZE + sizeof(send_array), sent_sizes[1]);
+    TEST_ASSERT_EQUAL_HEX16(IPV4_FLAG_DF, sent_frags[1]);
+    // Jumbo frames are received
+    loop_frame_back(out_buffer, out_buff_size);
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_EQUAL_INT(sizeof(send_array), received_size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(send_array, received_array, sizeof(send_array));
+}
+
+void test_network_ip_checksum(void) {
+    uint8_t ipAdr[4] = {192, 168, 2, 0};
+    uint8_t macAdr[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    uint8_t send_array[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    static uint8_t segment_array[2000];
+    uint8_t received_array[16];
+    uint16_t received_size;
+    uint8_t source_ip[4];
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlGetData_StubWithCallback(get_data_Callback);
+    MacCtrlSendData_StubWithCallback(capture_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    sent_nb = 0;
+
+    // Controller without checksum offload
+    TEST_ASSERT_TRUE(NetworkCtrlAdd(MAIN_NETWORK_CTRL, &NetworkSwChecksumCtrlDesc));
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkReasmPortDesc));
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, ipAdr, macAdr, false));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF, ip_header_sum(sent_frames[0]));
+    // Valid header is received
+    loop_frame_back(sent_frames[0], sent_sizes[0]);
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(send_array, received_array, sizeof(send_array));
+    // Corrupted header is dropped
+    sent_frames[0][22]--;
+    loop_frame_back(sent_frames[0], sent_sizes[0]);
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+    // Reused segment headers are updated incrementally
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkSegmentPortDesc));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, segment_array, sizeof(segment_array), NULL));
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(3, sent_nb);
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF, ip_header_sum(sent_frames[1]));
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF, ip_header_sum(sent_frames[2]));
+    TEST_ASSERT_EQUAL_INT(NETWORK_HEADER_SIZE + sizeof(segment_array) - ETHERNET_MAX_DATA_SIZE, sent_sizes[2]);
+}
+
+void test_network_udp_checksum(void) {
+    uint8_t ipAdr[4] = {192, 168, 2, 0};
+    uint8_t macAdr[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    uint8_t send_array[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    static uint8_t fragment_array[2000];
+    static uint8_t received_array[2000];
+    uint16_t received_size;
+    uint8_t source_ip[4];
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlGetData_StubWithCallback(get_data_Callback);
+    MacCtrlSendData_StubWithCallback(capture_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    sent_nb = 0;
+    for (uint16_t idx = 0; idx < sizeof(fragment_array); idx++) {
+        fragment_array[idx] = (uint8_t)(idx * 7);
+    }
+
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkUdpChecksumPortDesc));
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, ipAdr, macAdr, false));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    TEST_ASSERT_NOT_EQUAL(0, (sent_frames[0][40] << 8) | sent_frames[0][41]);
+    // Valid datagram is received
+    loop_frame_back(sent_frames[0], sent_sizes[0]);
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_EQUAL_INT(sizeof(send_array), received_size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(send_array, received_array, sizeof(send_array));
+    // Corrupted datagram is dropped
+    sent_frames[0][NETWORK_HEADER_SIZE + 3]++;
+    loop_frame_back(sent_frames[0], sent_sizes[0]);
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+    // Datagram without checksum is not verified
+    sent_frames[0][40] = 0;
+    sent_frames[0][41] = 0;
+    loop_frame_back(sent_frames[0], sent_sizes[0]);
+    TEST_ASSERT_FALSE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    // Checksum of a fragmented datagram covers the whole message
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, fragment_array, sizeof(fragment_array), NULL));
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(3, sent_nb);
+    loop_frame_back(sent_frames[1], sent_sizes[1]);
+    loop_frame_back(sent_frames[2], sent_sizes[2]);
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_EQUAL_INT(sizeof(fragment_array), received_size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(fragment_array, received_array, sizeof(fragment_array));
+}
+
+void test_network_offload(void) {
+    uint8_t ipAdr[4] = {192, 168, 2, 0};
+    uint8_t macAdr[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    uint8_t send_array[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    static uint8_t segment_array[2000];
+    uint8_t received_array[16];
+    uint16_t received_size;
+    uint8_t source_ip[4];
+    network_ctrl_desc_t badCtrlDesc = NetworkOffloadCtrlDesc;
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlGetData_StubWithCallback(get_data_Callback);
+    MacCtrlSendData_StubWithCallback(capture_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    sent_nb = 0;
+    for (uint16_t idx = 0; idx < sizeof(segment_array); idx++) {
+        segment_array[idx] = (uint8_t)idx;
+    }
+
+    // Gathered sends need their function
+    badCtrlDesc.ComInterface.MacCtrlSendMsgSg = NULL;
+    TEST_ASSERT_FALSE(NetworkCtrlAdd(MAIN_NETWORK_CTRL, &badCtrlDesc));
+    badCtrlDesc.ComInterface.Capabilities = NETWORK_CAP_TX_SEGMENT;
+    TEST_ASSERT_FALSE(NetworkCtrlAdd(MAIN_NETWORK_CTRL, &badCtrlDesc));
+    TEST_ASSERT_TRUE(NetworkCtrlAdd(MAIN_NETWORK_CTRL, &NetworkOffloadCtrlDesc));
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, ipAdr, macAdr, false));
+    // Data is gathered from the fifo, udp checksum is left to the mac
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkUdpChecksumPortDesc));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    TEST_ASSERT_EQUAL_INT(NETWORK_HEADER_SIZE + sizeof(send_array), out_buff_size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(send_array, out_buffer + NETWORK_HEADER_SIZE, sizeof(send_array));
+    TEST_ASSERT_EQUAL_HEX16(0, (out_buffer[40] << 8) | out_buffer[41]);
+    TEST_ASSERT_TRUE(NetworkPortIsTxEmpty(SEC_NETWORK_PORT));
+    // Received datagram was verified by the mac
+    out_buffer[40] = 0x12;
+    loop_frame_back(out_buffer, out_buff_size);
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(send_array, received_array, sizeof(send_array));
+    // Large message is segmented by the mac in one send
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkSegmentPortDesc));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, segment_array, sizeof(segment_array), NULL));
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(2, sent_nb);
+    TEST_ASSERT_EQUAL_INT(NETWORK_HEADER_SIZE + sizeof(segment_array), out_buff_size);
+    TEST_ASSERT_EQUAL_INT(ETHERNET_MAX_DATA_SIZE + UDP_HEADER_SIZE, (out_buffer[38] << 8) | out_buffer[39]);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(segment_array, out_buffer + NETWORK_HEADER_SIZE, sizeof(segment_array));
+    TEST_ASSERT_TRUE(NetworkPortIsTxEmpty(SEC_NETWORK_PORT));
+}
+
+void test_network_ip_alias(void) {
+    uint8_t aliasIp[4] = {10, 0, 0, 5};
+    uint8_t secAliasIp[4] = {10, 1, 0, 5};
+    uint8_t extraAliasIp[4] = {10, 2, 0, 5};
+    uint8_t aliasMask[4] = {255, 255, 255, 0};
+    uint8_t peerIp[4] = {10, 0, 0, 9};
+    uint8_t peerMac[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    uint8_t send_array[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    uint8_t received_array[16];
+    uint16_t received_size;
+    uint8_t source_ip[4];
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlGetData_StubWithCallback(get_data_Callback);
+    MacCtrlSendData_StubWithCallback(capture_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    sent_nb = 0;
+
+    // Alias table
+    TEST_ASSERT_FALSE(NetworkPortSetDstIpAddress(MAIN_NETWORK_PORT, peerIp));
+    TEST_ASSERT_TRUE(NetworkCtrlAddIpAlias(MAIN_NETWORK_CTRL, aliasIp, aliasMask));
+    TEST_ASSERT_FALSE(NetworkCtrlAddIpAlias(MAIN_NETWORK_CTRL, aliasIp, aliasMask));
+    TEST_ASSERT_FALSE(NetworkCtrlAddIpAlias(MAIN_NETWORK_CTRL, NetworkMainCtrlDesc.DefaultIpAddr, aliasMask));
+    TEST_ASSERT_TRUE(NetworkCtrlAddIpAlias(MAIN_NETWORK_CTRL, secAliasIp, aliasMask));
+    TEST_ASSERT_FALSE(NetworkCtrlAddIpAlias(MAIN_NETWORK_CTRL, extraAliasIp, aliasMask));
+    TEST_ASSERT_TRUE(NetworkCtrlRemoveIpAlias(MAIN_NETWORK_CTRL, secAliasIp));
+    TEST_ASSERT_FALSE(NetworkCtrlRemoveIpAlias(MAIN_NETWORK_CTRL, secAliasIp));
+    TEST_ASSERT_FALSE(NetworkCtrlRemoveIpAlias(MAIN_NETWORK_CTRL, NetworkMainCtrlDesc.DefaultIpAddr));
+    // Arp requests for an alias are answered from the alias
+    memcpy(in_buffer, arp_req_ext, sizeof(arp_req_ext));
+    memcpy(in_buffer + 28, peerIp, sizeof(peerIp));
+    memcpy(in_buffer + 38, aliasIp, sizeof(aliasIp));
+    in_buff_size = sizeof(arp_req_ext);
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    TEST_ASSERT_EQUAL_HEX8(ARP_REPLY, sent_frames[0][21]);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(aliasIp, sent_frames[0] + 28, 4);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(peerIp, sent_frames[0] + 38, 4);
+    // Datagrams to the alias subnet are sent from the alias
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkReasmPortDesc));
+    TEST_ASSERT_TRUE(NetworkPortSetDstIpAddress(SEC_NETWORK_PORT, peerIp));
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, peerIp, peerMac, false));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(2, sent_nb);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(aliasIp, sent_frames[1] + 26, 4);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(peerIp, sent_frames[1] + 30, 4);
+    // Datagrams from the alias subnet to the alias are received
+    memcpy(in_buffer, sent_frames[1], sent_sizes[1]);
+    memcpy(in_buffer, sent_frames[1] + 6, 6);
+    memcpy(in_buffer + 6, peerMac, sizeof(peerMac));
+    memcpy(in_buffer + 26, peerIp, sizeof(peerIp));
+    memcpy(in_buffer + 30, aliasIp, sizeof(aliasIp));
+    in_buff_size = sent_sizes[1];
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(send_array, received_array, sizeof(send_array));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(peerIp, source_ip, 4);
+    // Senders outside the alias subnet are rejected
+    memcpy(in_buffer + 26, NetworkMainPortDesc.DefaultDstIpAddr, 4);
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+}
+
+void test_network_routing(void) {
+    uint8_t remoteIp[4] = {10, 20, 0, 7};
+    uint8_t remoteNet[4] = {10, 20, 0, 0};
+    uint8_t otherNet[4] = {10, 30, 0, 0};
+    uint8_t extraNet[4] = {10, 40, 0, 0};
+    uint8_t remoteMask[4] = {255, 255, 0, 0};
+    uint8_t badMask[4] = {255, 0, 255, 0};
+    uint8_t noGateway[4] = {0, 0, 0, 0};
+    uint8_t gatewayIp[4] = {192, 168, 2, 1};
+    uint8_t routerIp[4] = {192, 168, 2, 2};
+    uint8_t offLinkIp[4] = {10, 0, 0, 1};
+    uint8_t gatewayMac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    uint8_t routerMac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+    uint8_t send_array[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    uint8_t received_array[16];
+    uint16_t received_size;
+    uint8_t source_ip[4];
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlGetData_StubWithCallback(get_data_Callback);
+    MacCtrlSendData_StubWithCallback(capture_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    sent_nb = 0;
+
+    // Routing table
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkReasmPortDesc));
+    TEST_ASSERT_FALSE(NetworkPortSetDstIpAddress(SEC_NETWORK_PORT, remoteIp));
+    TEST_ASSERT_FALSE(NetworkCtrlSetGateway(MAIN_NETWORK_CTRL, offLinkIp));
+    TEST_ASSERT_FALSE(NetworkCtrlAddRoute(MAIN_NETWORK_CTRL, remoteNet, badMask, routerIp));
+    TEST_ASSERT_FALSE(NetworkCtrlAddRoute(MAIN_NETWORK_CTRL, remoteNet, noGateway, routerIp));
+    TEST_ASSERT_TRUE(NetworkCtrlSetGateway(MAIN_NETWORK_CTRL, gatewayIp));
+    TEST_ASSERT_TRUE(NetworkPortSetDstIpAddress(SEC_NETWORK_PORT, remoteIp));
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, gatewayIp, gatewayMac, false));
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, routerIp, routerMac, false));
+    // Off-subnet datagrams are sent to the default gateway
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(gatewayMac, sent_frames[0], 6);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(NetworkMainCtrlDesc.DefaultIpAddr, sent_frames[0] + 26, 4);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(remoteIp, sent_frames[0] + 30, 4);
+    // The longest matching route wins over the default gateway
+    TEST_ASSERT_TRUE(NetworkCtrlAddRoute(MAIN_NETWORK_CTRL, remoteNet, remoteMask, routerIp));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(2, sent_nb);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(routerMac, sent_frames[1], 6);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(remoteIp, sent_frames[1] + 30, 4);
+    // Table size excludes the default gateway, same prefix routes are replaced
+    TEST_ASSERT_TRUE(NetworkCtrlAddRoute(MAIN_NETWORK_CTRL, otherNet, remoteMask, routerIp));
+    TEST_ASSERT_FALSE(NetworkCtrlAddRoute(MAIN_NETWORK_CTRL, extraNet, remoteMask, routerIp));
+    TEST_ASSERT_TRUE(NetworkCtrlAddRoute(MAIN_NETWORK_CTRL, otherNet, remoteMask, gatewayIp));
+    TEST_ASSERT_TRUE(NetworkCtrlSetGateway(MAIN_NETWORK_CTRL, routerIp));
+    TEST_ASSERT_TRUE(NetworkCtrlSetGateway(MAIN_NETWORK_CTRL, gatewayIp));
+    // Datagrams from routed senders are received
+    memcpy(in_buffer, sent_frames[1], sent_sizes[1]);
+    memcpy(in_buffer, sent_frames[1] + 6, 6);
+    memcpy(in_buffer + 6, routerMac, sizeof(routerMac));
+    memcpy(in_buffer + 26, remoteIp, sizeof(remoteIp));
+    memcpy(in_buffer + 30, NetworkMainCtrlDesc.DefaultIpAddr, 4);
+    in_buff_size = sent_sizes[1];
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(send_array, received_array, sizeof(send_array));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(remoteIp, source_ip, 4);
+    // Removed routes fall back to the default gateway, then to nothing
+    TEST_ASSERT_TRUE(NetworkCtrlRemoveRoute(MAIN_NETWORK_CTRL, remoteNet, remoteMask));
+    TEST_ASSERT_FALSE(NetworkCtrlRemoveRoute(MAIN_NETWORK_CTRL, remoteNet, remoteMask));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(3, sent_nb);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(gatewayMac, sent_frames[2], 6);
+    TEST_ASSERT_TRUE(NetworkCtrlSetGateway(MAIN_NETWORK_CTRL, noGateway));
+    TEST_ASSERT_FALSE(NetworkPortSetDstIpAddress(SEC_NETWORK_PORT, remoteIp));
+}
+
+void test_network_multicast(void) {
+    uint8_t groupIp[4] = {239, 1, 2, 3};
+    uint8_t otherGroupIp[4] = {239, 1, 2, 4};
+    uint8_t allHostsIp[4] = {224, 0, 0, 1};
+    uint8_t allRoutersIp[4] = {224, 0, 0, 2};
+    uint8_t noGroupIp[4] = {0, 0, 0, 0};
+    uint8_t firstGroupIp[4] = {239, 0, 0, 1};
+    uint8_t collidingGroupIp[4] = {239, 0, 0, 5};
+    uint8_t nextGroupIp[4] = {239, 0, 0, 2};
+    uint8_t collidingGroupMac[6] = {0x01, 0x00, 0x5e, 0x00, 0x00, 0x05};
+    uint8_t groupMac[6] = {0x01, 0x00, 0x5e, 0x01, 0x02, 0x03};
+    uint8_t peerIp[4] = {192, 168, 2, 9};
+    uint8_t peerMac[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    uint8_t send_array[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    uint8_t group_frame[ETHERNET_FRAME_LENTGH_MAX];
+    uint16_t group_frame_size;
+    uint8_t received_array[16];
+    uint16_t received_size;
+    uint8_t source_ip[4];
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlGetData_StubWithCallback(get_data_Callback);
+    MacCtrlSendData_StubWithCallback(capture_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    sent_nb = 0;
+
+    // Group subscriptions
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkReasmPortDesc));
+    TEST_ASSERT_FALSE(NetworkPortJoinGroup(SEC_NETWORK_PORT, peerIp));
+    TEST_ASSERT_FALSE(NetworkPortJoinGroup(SEC_NETWORK_PORT, allHostsIp));
+    TEST_ASSERT_FALSE(NetworkPortLeaveGroup(SEC_NETWORK_PORT, groupIp));
+    // The first subscriber reports the group
+    TEST_ASSERT_TRUE(NetworkPortJoinGroup(SEC_NETWORK_PORT, groupIp));
+    TEST_ASSERT_TRUE(NetworkPortJoinGroup(SEC_NETWORK_PORT, groupIp));
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(groupMac, sent_frames[0], 6);
+    TEST_ASSERT_EQUAL_HEX8(1, sent_frames[0][22]);
+    TEST_ASSERT_EQUAL_HEX8(IP_PROT_IGMP, sent_frames[0][23]);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(groupIp, sent_frames[0] + 30, 4);
+    TEST_ASSERT_EQUAL_HEX8(IGMP_V2_MEMBERSHIP_REPORT, sent_frames[0][34]);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(groupIp, sent_frames[0] + 38, 4);
+    TEST_ASSERT_EQUAL_HEX16(0, UtilsInetChecksum(sent_frames[0] + 34, IGMP_HEADER_SIZE));
+    // Group datagrams are sent to the group mac address, without arp
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), groupIp));
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(2, sent_nb);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(groupMac, sent_frames[1], 6);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(groupIp, sent_frames[1] + 30, 4);
+    memcpy(group_frame, sent_frames[1], sent_sizes[1]);
+    memcpy(group_frame + 6, peerMac, sizeof(peerMac));
+    memcpy(group_frame + 26, peerIp, sizeof(peerIp));
+    group_frame_size = sent_sizes[1];
+    // Group datagrams fan out to the subscribed ports only
+    TEST_ASSERT_TRUE(NetworkPortSetInPortNb(MAIN_NETWORK_PORT, NetworkReasmPortDesc.DefaultInPortNb));
+    memcpy(in_buffer, group_frame, group_frame_size);
+    in_buff_size = group_frame_size;
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(MAIN_NETWORK_PORT));
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(send_array, received_array, sizeof(send_array));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(peerIp, source_ip, 4);
+    TEST_ASSERT_TRUE(NetworkPortJoinGroup(MAIN_NETWORK_PORT, groupIp));
+    TEST_ASSERT_EQUAL_INT(2, sent_nb);
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_FALSE(NetworkPortIsRxEmpty(MAIN_NETWORK_PORT));
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_EQUAL_INT(sizeof(send_array), received_size);
+    // Other groups are filtered
+    memcpy(in_buffer + 30, otherGroupIp, sizeof(otherGroupIp));
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+    // General queries are answered with a report per group
+    memcpy(in_buffer, sent_frames[0], sent_sizes[0]);
+    memcpy(in_buffer + 6, peerMac, sizeof(peerMac));
+    memcpy(in_buffer + 26, peerIp, sizeof(peerIp));
+    memcpy(in_buffer + 30, allHostsIp, sizeof(allHostsIp));
+    in_buffer[34] = IGMP_MEMBERSHIP_QUERY;
+    in_buffer[36] = 0;
+    in_buffer[37] = 0;
+    memcpy(in_buffer + 38, noGroupIp, sizeof(noGroupIp));
+    uint16_t queryChecksum = UtilsInetChecksum(in_buffer + 34, IGMP_HEADER_SIZE);
+    in_buffer[36] = (uint8_t)(queryChecksum >> 8);
+    in_buffer[37] = (uint8_t)queryChecksum;
+    in_buff_size = sent_sizes[0];
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_EQUAL_INT(3, sent_nb);
+    TEST_ASSERT_EQUAL_HEX8(IGMP_V2_MEMBERSHIP_REPORT, sent_frames[2][34]);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(groupIp, sent_frames[2] + 38, 4);
+    // The last subscriber leaves the group
+    sent_nb = 0;
+    TEST_ASSERT_TRUE(NetworkPortLeaveGroup(MAIN_NETWORK_PORT, groupIp));
+    TEST_ASSERT_EQUAL_INT(0, sent_nb);
+    TEST_ASSERT_TRUE(NetworkPortLeaveGroup(SEC_NETWORK_PORT, groupIp));
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    TEST_ASSERT_EQUAL_HEX8(IGMP_LEAVE_GROUP, sent_frames[0][34]);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(allRoutersIp, sent_frames[0] + 30, 4);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(groupIp, sent_frames[0] + 38, 4);
+    memcpy(in_buffer, group_frame, group_frame_size);
+    in_buff_size = group_frame_size;
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+    // Groups of a probe run keep their subscribers when an earlier group leaves
+    TEST_ASSERT_TRUE(NetworkPortJoinGroup(SEC_NETWORK_PORT, firstGroupIp));
+    TEST_ASSERT_TRUE(NetworkPortJoinGroup(SEC_NETWORK_PORT, collidingGroupIp));
+    TEST_ASSERT_TRUE(NetworkPortLeaveGroup(SEC_NETWORK_PORT, firstGroupIp));
+    memcpy(in_buffer, collidingGroupMac, sizeof(collidingGroupMac));
+    memcpy(in_buffer + 30, collidingGroupIp, sizeof(collidingGroupIp));
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_FALSE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+    TEST_ASSERT_TRUE(NetworkPortLeaveGroup(SEC_NETWORK_PORT, collidingGroupIp));
+    // An entry placed back in its own hash slot keeps its subscribers
+    TEST_ASSERT_TRUE(NetworkPortJoinGroup(SEC_NETWORK_PORT, nextGroupIp));
+    TEST_ASSERT_TRUE(NetworkPortJoinGroup(SEC_NETWORK_PORT, firstGroupIp));
+    TEST_ASSERT_TRUE(NetworkPortLeaveGroup(SEC_NETWORK_PORT, nextGroupIp));
+    TEST_ASSERT_TRUE(NetworkPortLeaveGroup(SEC_NETWORK_PORT, firstGroupIp));
+}
+
+void test_network_reuseport(void) {
+    uint8_t received_array[64];
+    uint16_t received_size;
+    uint16_t received_nb[NETWORK_PORT_COUNT] = {0, 0};
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlGetData_StubWithCallback(get_data_Callback);
+    MacCtrlSendData_StubWithCallback(send_data_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+
+    // Both ports share the same local port
+    TEST_ASSERT_TRUE(NetworkPortAdd(MAIN_NETWORK_PORT, &NetworkReusePortDesc));
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkReusePortDesc));
+    memcpy(in_buffer, udp_com_rx_barray, sizeof(udp_com_rx_barray));
+    in_buff_size = sizeof(udp_com_rx_barray);
+    // Each datagram goes to one port, the same one for a given sender flow
+    for (uint16_t flowIdx = 0; flowIdx < 16; flowIdx++) {
+        in_buffer[34] = (uint8_t)(40000 >> 8);
+        in_buffer[35] = (uint8_t)flowIdx;
+        for (uint8_t msgIdx = 0; msgIdx < 2; msgIdx++) {
+            hasData = true;
+            NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+            hasData = false;
+        }
+        uint8_t portId = NetworkPortIsRxEmpty(MAIN_NETWORK_PORT) ? SEC_NETWORK_PORT : MAIN_NETWORK_PORT;
+        TEST_ASSERT_TRUE(NetworkPortIsRxEmpty((portId == MAIN_NETWORK_PORT) ? SEC_NETWORK_PORT : MAIN_NETWORK_PORT));
+        TEST_ASSERT_TRUE(NetworkPortReadBuff(portId, received_array, &received_size, sizeof(received_array), NULL));
+        TEST_ASSERT_TRUE(NetworkPortReadBuff(portId, received_array, &received_size, sizeof(received_array), NULL));
+        TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(portId));
+        received_nb[portId]++;
+    }
+    // Flows are spread over the ports
+    TEST_ASSERT_NOT_EQUAL(0, received_nb[MAIN_NETWORK_PORT]);
+    TEST_ASSERT_NOT_EQUAL(0, received_nb[SEC_NETWORK_PORT]);
+    // Ports without the option still receive every datagram
+    TEST_ASSERT_TRUE(NetworkPortAdd(MAIN_NETWORK_PORT, &NetworkSecPortDesc));
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_FALSE(NetworkPortIsRxEmpty(MAIN_NETWORK_PORT));
+    TEST_ASSERT_FALSE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+}
+
+void test_network_connected_port(void) {
+    uint8_t peerIp[4] = {192, 168, 2, 16};
+    uint8_t secPeerIp[4] = {192, 168, 2, 17};
+    uint8_t otherIp[4] = {192, 168, 2, 18};
+    uint8_t groupIp[4] = {239, 1, 2, 3};
+    uint8_t received_array[64];
+    uint16_t received_size;
+    uint8_t source_ip[4];
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlGetData_StubWithCallback(get_data_Callback);
+    MacCtrlSendData_StubWithCallback(send_data_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+
+    // Two ports connected to different peers share the same local port
+    TEST_ASSERT_TRUE(NetworkPortAdd(MAIN_NETWORK_PORT, &NetworkConnectedPortDesc));
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkConnectedPortDesc));
+    TEST_ASSERT_FALSE(NetworkPortConnect(SEC_NETWORK_PORT, groupIp, 25565));
+    TEST_ASSERT_TRUE(NetworkPortConnect(SEC_NETWORK_PORT, secPeerIp, 25565));
+    memcpy(in_buffer, udp_com_rx_barray, sizeof(udp_com_rx_barray));
+    in_buff_size = sizeof(udp_com_rx_barray);
+    // Datagrams go to the port of their endpoints
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(MAIN_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(peerIp, source_ip, 4);
+    memcpy(in_buffer + 26, secPeerIp, sizeof(secPeerIp));
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(MAIN_NETWORK_PORT));
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(secPeerIp, source_ip, 4);
+    // Unrelated traffic is dropped
+    memcpy(in_buffer + 26, otherIp, sizeof(otherIp));
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(MAIN_NETWORK_PORT));
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+    // Endpoint changes move the port
+    TEST_ASSERT_TRUE(NetworkPortSetDstIpAddress(MAIN_NETWORK_PORT, otherIp));
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_FALSE(NetworkPortIsRxEmpty(MAIN_NETWORK_PORT));
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(MAIN_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_TRUE(NetworkPortSetOutPortNb(MAIN_NETWORK_PORT, 1234));
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(MAIN_NETWORK_PORT));
+    // Disconnected ports receive from any source
+    TEST_ASSERT_TRUE(NetworkPortDisconnect(SEC_NETWORK_PORT));
+    TEST_ASSERT_FALSE(NetworkPortDisconnect(SEC_NETWORK_PORT));
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(MAIN_NETWORK_PORT));
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), source_ip));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(otherIp, source_ip, 4);
+}
+
+void test_network_port_open_close(void) {
+    uint8_t received_array[64];
+    uint16_t received_size;
+    uint8_t source_ip[4];
+    uint8_t portId;
+    uint8_t reopenPortId;
+    uint16_t inPortNb;
+    int allocNb;
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlGetData_StubWithCallback(get_data_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+
+    // Ephemeral local port in the free port slot
+    TEST_ASSERT_FALSE(NetworkPortOpen(NULL, &portId));
+    TEST_ASSERT_TRUE(NetworkPortOpen(&NetworkEphemeralPortDesc, &portId));
+    TEST_ASSERT_EQUAL_INT(SEC_NETWORK_PORT, portId);
+    inPortNb = NetworkPortGetInPortNb(portId);
+    TEST_ASSERT_EQUAL_INT(NETWORK_EPHEMERAL_PORT_MIN, inPortNb);
+    TEST_ASSERT_FALSE(NetworkPortOpen(&NetworkEphemeralPortDesc, &reopenPortId));
+    // Datagrams to the ephemeral port are received
+    memcpy(in_buffer, udp_com_rx_barray, sizeof(udp_com_rx_barray));
+    in_buff_size = sizeof(udp_com_rx_barray);
+    in_buffer[36] = (uint8_t)(inPortNb >> 8);
+    in_buffer[37] = (uint8_t)inPortNb;
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_FALSE(NetworkPortIsRxEmpty(portId));
+    // Closed ports are invalid and their pending data discarded
+    TEST_ASSERT_TRUE(NetworkPortClose(portId));
+    TEST_ASSERT_FALSE(NetworkPortClose(portId));
+    TEST_ASSERT_FALSE(NetworkPortIsRxEmpty(portId));
+    TEST_ASSERT_FALSE(NetworkPortSendBuff(portId, (const uint8_t *)"Jacobian", 8, NULL));
+    // Reopened port recycles the slot fifos with the next ephemeral port
+    allocNb = memIdx;
+    TEST_ASSERT_TRUE(NetworkPortOpen(&NetworkEphemeralPortDesc, &reopenPortId));
+    TEST_ASSERT_EQUAL_INT(portId, reopenPortId);
+    TEST_ASSERT_EQUAL_INT(allocNb, memIdx);
+    TEST_ASSERT_EQUAL_INT(NETWORK_EPHEMERAL_PORT_MIN + 1, NetworkPortGetInPortNb(portId));
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(portId));
+    // Former ephemeral port is not delivered anymore
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(portId));
+    TEST_ASSERT_FALSE(NetworkPortReadBuff(portId, received_array, &received_size, sizeof(received_array), source_ip));
+}
+
+void test_network_sendto_recvfrom(void) {
+    uint8_t peerIp[4] = {192, 168, 2, 16};
+    uint8_t peerMac[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    uint8_t send_array[] = {0, 1, 2, 3, 4};
+    uint8_t received_array[64];
+    uint16_t received_size;
+    network_endpoint_t peer = {{192, 168, 2, 16}, 4242};
+    network_endpoint_t farPeer = {{10, 0, 0, 1}, 4242};
+    network_endpoint_t source;
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlGetData_StubWithCallback(get_data_Callback);
+    MacCtrlSendData_StubWithCallback(record_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    sent_nb = 0;
+
+    // Messages go to the given endpoint
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, peerIp, peerMac, false));
+    TEST_ASSERT_EQUAL_INT(NETWORK_SOCK_OK, NetworkPortSendTo(MAIN_NETWORK_PORT, send_array, sizeof(send_array), &peer, 0));
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(peerIp, out_buffer + 30, 4);
+    TEST_ASSERT_EQUAL_INT(4242, (out_buffer[36] << 8) | out_buffer[37]);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(send_array, out_buffer + NETWORK_HEADER_SIZE, sizeof(send_array));
+    // Send errors
+    TEST_ASSERT_EQUAL_INT(NETWORK_SOCK_NO_ROUTE, NetworkPortSendTo(MAIN_NETWORK_PORT, send_array, sizeof(send_array), &farPeer, 0));
+    TEST_ASSERT_EQUAL_INT(NETWORK_SOCK_TOO_BIG, NetworkPortSendTo(MAIN_NETWORK_PORT, in_buffer, UDP_MAX_DATA_SIZE, &peer, 0));
+    TEST_ASSERT_EQUAL_INT(NETWORK_SOCK_INVALID, NetworkPortSendTo(SEC_NETWORK_PORT, send_array, sizeof(send_array), &peer, 0));
+    for (uint8_t msgIdx = 0; msgIdx < NetworkMainPortDesc.TxDescFifoSize; msgIdx++) {
+        TEST_ASSERT_EQUAL_INT(NETWORK_SOCK_OK, NetworkPortSendTo(MAIN_NETWORK_PORT, send_array, sizeof(send_array), NULL, 0));
+    }
+    TEST_ASSERT_EQUAL_INT(NETWORK_SOCK_WOULD_BLOCK, NetworkPortSendTo(MAIN_NETWORK_PORT, send_array, sizeof(send_array), NULL, 0));
+    // Only routed recipients use the gateway
+    TEST_ASSERT_TRUE(NetworkCtrlSetGateway(MAIN_NETWORK_CTRL, peerIp));
+    TEST_ASSERT_EQUAL_INT(NETWORK_SOCK_NO_ROUTE, NetworkPortSendTo(MAIN_NETWORK_PORT, send_array, sizeof(send_array), &farPeer, NETWORK_MSG_DONTROUTE));
+
+    // Received messages come with their sender endpoint
+    TEST_ASSERT_EQUAL_INT(NETWORK_SOCK_WOULD_BLOCK, NetworkPortRecvFrom(MAIN_NETWORK_PORT, received_array, sizeof(received_array), &received_size, &source, 0));
+    memcpy(in_buffer, udp_com_rx_barray, sizeof(udp_com_rx_barray));
+    in_buff_size = sizeof(udp_com_rx_barray);
+    in_buffer[36] = (uint8_t)(NetworkMainPortDesc.DefaultInPortNb >> 8);
+    in_buffer[37] = (uint8_t)NetworkMainPortDesc.DefaultInPortNb;
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_EQUAL_INT(NETWORK_SOCK_TOO_BIG, NetworkPortRecvFrom(MAIN_NETWORK_PORT, received_array, 4, &received_size, &source, 0));
+    TEST_ASSERT_EQUAL_INT(NETWORK_SOCK_OK, NetworkPortRecvFrom(MAIN_NETWORK_PORT, received_array, sizeof(received_array), &received_size, &source, NETWORK_MSG_PEEK));
+    TEST_ASSERT_EQUAL_INT(14, received_size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(peerIp, source.IpAddr, 4);
+    TEST_ASSERT_EQUAL_INT(25565, source.PortNb);
+    TEST_ASSERT_EQUAL_INT(NETWORK_SOCK_OK, NetworkPortRecvFrom(MAIN_NETWORK_PORT, received_array, 7, &received_size, NULL, NETWORK_MSG_TRUNC));
+    TEST_ASSERT_EQUAL_INT(7, received_size);
+    TEST_ASSERT_EQUAL_MEMORY("Hessian", received_array, 7);
+    TEST_ASSERT_EQUAL_INT(NETWORK_SOCK_WOULD_BLOCK, NetworkPortRecvFrom(MAIN_NETWORK_PORT, received_array, sizeof(received_array), &received_size, &source, 0));
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(MAIN_NETWORK_PORT));
+}
+
+void test_network_read_batch(void) {
+    uint8_t peerIp[4] = {192, 168, 2, 16};
+    uint8_t received_arrays[4][16];
+    network_msg_entry_t entries[4];
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlGetData_StubWithCallback(get_data_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    for (uint8_t entryIdx = 0; entryIdx < 4; entryIdx++) {
+        entries[entryIdx].pBuffer = received_arrays[entryIdx];
+        entries[entryIdx].BuffSize = sizeof(received_arrays[entryIdx]);
+    }
+
+    // Successive batches roll over the descriptor fifo
+    TEST_ASSERT_EQUAL_INT(0, NetworkPortReadBatch(MAIN_NETWORK_PORT, entries, 4));
+    memcpy(in_buffer, udp_com_rx_barray, sizeof(udp_com_rx_barray));
+    in_buff_size = sizeof(udp_com_rx_barray);
+    in_buffer[36] = (uint8_t)(NetworkMainPortDesc.DefaultInPortNb >> 8);
+    in_buffer[37] = (uint8_t)NetworkMainPortDesc.DefaultInPortNb;
+    for (uint8_t loopIdx = 0; loopIdx < 8; loopIdx++) {
+        for (uint8_t msgIdx = 0; msgIdx < 3; msgIdx++) {
+            in_buffer[NETWORK_HEADER_SIZE] = (uint8_t)('a' + msgIdx);
+            hasData = true;
+            NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+            hasData = false;
+        }
+        TEST_ASSERT_EQUAL_INT(3, NetworkPortReadBatch(MAIN_NETWORK_PORT, entries, 4));
+        for (uint8_t msgIdx = 0; msgIdx < 3; msgIdx++) {
+            TEST_ASSERT_EQUAL_INT(14, entries[msgIdx].DataSize);
+            TEST_ASSERT_EQUAL_INT('a' + msgIdx, received_arrays[msgIdx][0]);
+            TEST_ASSERT_EQUAL_MEMORY("essian matrix", received_arrays[msgIdx] + 1, 13);
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(peerIp, entries[msgIdx].Endpoint.IpAddr, 4);
+            TEST_ASSERT_EQUAL_INT(25565, entries[msgIdx].Endpoint.PortNb);
+        }
+    }
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(MAIN_NETWORK_PORT));
+    // Reading stops at a message too large for its entry
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    entries[1].BuffSize = 8;
+    TEST_ASSERT_EQUAL_INT(1, NetworkPortReadBatch(MAIN_NETWORK_PORT, entries, 4));
+    TEST_ASSERT_EQUAL_INT(1, NetworkPortReadBatch(MAIN_NETWORK_PORT, entries, 1));
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(MAIN_NETWORK_PORT));
+}
+
+void test_network_send_batch(void) {
+    uint8_t peerIp[4] = {192, 168, 2, 16};
+    uint8_t peerMac[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    uint8_t send_arrays[3][4] = {{0, 1, 2, 3}, {4, 5, 6, 7}, {8, 9, 10, 11}};
+    network_msg_entry_t entries[24];
+
+    // Mac_ctrl spoofing
+    MacCtrlSendData_StubWithCallback(record_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    timeVal = 0;
+    sent_nb = 0;
+    for (uint8_t entryIdx = 0; entryIdx < 24; entryIdx++) {
+        entries[entryIdx].pBuffer = send_arrays[entryIdx % 3];
+        entries[entryIdx].DataSize = sizeof(send_arrays[0]);
+        memcpy(entries[entryIdx].Endpoint.IpAddr, peerIp, sizeof(peerIp));
+        entries[entryIdx].Endpoint.PortNb = (uint16_t)(4000 + entryIdx);
+    }
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, peerIp, peerMac, false));
+
+    // Batches are queued whole or not at all
+    TEST_ASSERT_FALSE(NetworkPortSendBatch(MAIN_NETWORK_PORT, entries, 24));
+    TEST_ASSERT_TRUE(NetworkPortIsTxEmpty(MAIN_NETWORK_PORT));
+    entries[2].DataSize = UDP_MAX_DATA_SIZE;
+    TEST_ASSERT_FALSE(NetworkPortSendBatch(MAIN_NETWORK_PORT, entries, 3));
+    entries[2].DataSize = sizeof(send_arrays[0]);
+    TEST_ASSERT_TRUE(NetworkPortIsTxEmpty(MAIN_NETWORK_PORT));
+    // Best effort port sends a whole batch in one pass
+    TEST_ASSERT_TRUE(NetworkPortSendBatch(MAIN_NETWORK_PORT, entries, 3));
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(3, sent_nb);
+    TEST_ASSERT_TRUE(NetworkPortIsTxEmpty(MAIN_NETWORK_PORT));
+    TEST_ASSERT_EQUAL_INT(4002, (out_buffer[36] << 8) | out_buffer[37]);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(send_arrays[2], out_buffer + NETWORK_HEADER_SIZE, sizeof(send_arrays[2]));
+    // Messages queued one by one are still sent one per pass
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(MAIN_NETWORK_PORT, send_arrays[0], sizeof(send_arrays[0]), peerIp));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(MAIN_NETWORK_PORT, send_arrays[1], sizeof(send_arrays[1]), peerIp));
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(4, sent_nb);
+    TEST_ASSERT_FALSE(NetworkPortIsTxEmpty(MAIN_NETWORK_PORT));
+}
+
+void test_network_recv_peek(void) {
+    uint8_t peerIp[4] = {192, 168, 2, 16};
+    uint8_t received_array[16];
+    network_sg_entry_t spans[2];
+    network_endpoint_t source;
+    bool hasRolledOver = false;
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlGetData_StubWithCallback(get_data_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+
+    TEST_ASSERT_FALSE(NetworkPortRecvPeek(MAIN_NETWORK_PORT, spans, &source));
+    TEST_ASSERT_FALSE(NetworkPortRecvRelease(MAIN_NETWORK_PORT));
+    memcpy(in_buffer, udp_com_rx_barray, sizeof(udp_com_rx_barray));
+    in_buff_size = sizeof(udp_com_rx_barray);
+    in_buffer[36] = (uint8_t)(NetworkMainPortDesc.DefaultInPortNb >> 8);
+    in_buffer[37] = (uint8_t)NetworkMainPortDesc.DefaultInPortNb;
+    // Messages are read in place until one rolls over the end of the fifo
+    for (uint16_t msgIdx = 0; msgIdx <= (NetworkMainPortDesc.RxFifoSize / 14); msgIdx++) {
+        hasData = true;
+        NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+        hasData = false;
+        TEST_ASSERT_TRUE(NetworkPortRecvPeek(MAIN_NETWORK_PORT, spans, &source));
+        TEST_ASSERT_EQUAL_INT(14, spans[0].Size + spans[1].Size);
+        hasRolledOver |= (spans[1].Size != 0);
+        memcpy(received_array, spans[0].pData, spans[0].Size);
+        memcpy(received_array + spans[0].Size, spans[1].pData, spans[1].Size);
+        TEST_ASSERT_EQUAL_MEMORY("Hessian matrix", received_array, 14);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(peerIp, source.IpAddr, 4);
+        TEST_ASSERT_EQUAL_INT(25565, source.PortNb);
+        // Peeking again gives the same message
+        TEST_ASSERT_TRUE(NetworkPortRecvPeek(MAIN_NETWORK_PORT, spans, NULL));
+        TEST_ASSERT_TRUE(NetworkPortRecvRelease(MAIN_NETWORK_PORT));
+        TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(MAIN_NETWORK_PORT));
+    }
+    TEST_ASSERT_TRUE(hasRolledOver);
+}
+
+void test_network_send_now(void) {
+    uint8_t peerIp[4] = {192, 168, 2, 16};
+    uint8_t otherIp[4] = {192, 168, 2, 17};
+    uint8_t peerMac[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    uint8_t send_array[] = {0, 1, 2, 3, 4};
+
+    // Mac_ctrl spoofing
+    MacCtrlSendData_StubWithCallback(record_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    timeVal = 0;
+    sent_nb = 0;
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, peerIp, peerMac, false));
+
+    // Known recipient, the datagram is sent without tx pass
+    TEST_ASSERT_TRUE(NetworkPortSendNow(MAIN_NETWORK_PORT, send_array, sizeof(send_array), peerIp));
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    TEST_ASSERT_TRUE(NetworkPortIsTxEmpty(MAIN_NETWORK_PORT));
+    TEST_ASSERT_EQUAL_INT(NETWORK_HEADER_SIZE + sizeof(send_array), out_buff_size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(peerMac, out_buffer, 6);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(peerIp, out_buffer + 30, 4);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(send_array, out_buffer + NETWORK_HEADER_SIZE, sizeof(send_array));
+    // Unresolved recipient, the message is queued
+    TEST_ASSERT_TRUE(NetworkPortSendNow(MAIN_NETWORK_PORT, send_array, sizeof(send_array), otherIp));
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    TEST_ASSERT_FALSE(NetworkPortIsTxEmpty(MAIN_NETWORK_PORT));
+    // Queued messages keep their order
+    TEST_ASSERT_TRUE(NetworkPortSendNow(MAIN_NETWORK_PORT, send_array, sizeof(send_array), peerIp));
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    TEST_ASSERT_FALSE(NetworkPortSendNow(MAIN_NETWORK_PORT, in_buffer, UDP_MAX_DATA_SIZE, peerIp));
+}
+
+void test_network_send_now_mac_busy(void) {
+    uint8_t peerIp[4] = {192, 168, 2, 16};
+    uint8_t peerMac[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    uint8_t send_array[] = {0, 1, 2, 3, 4};
+
+    // Mac_ctrl spoofing
+    MacCtrlSendData_StubWithCallback(busy_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    timeVal = 0;
+    sent_nb = 0;
+
+    // Add shaped network port (47 bytes frames, 100 bytes burst)
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkShapedPortDesc));
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, peerIp, peerMac, false));
+    // Message the mac fails to send is queued
+    TEST_ASSERT_TRUE(NetworkPortSendNow(SEC_NETWORK_PORT, send_array, sizeof(send_array), peerIp));
+    TEST_ASSERT_FALSE(NetworkPortIsTxEmpty(SEC_NETWORK_PORT));
+    // Its tokens were given back, the bucket still holds two frames
+    MacCtrlSendData_StubWithCallback(record_send_Callback);
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    TEST_ASSERT_TRUE(NetworkPortIsTxEmpty(SEC_NETWORK_PORT));
+    TEST_ASSERT_TRUE(NetworkPortSendNow(SEC_NETWORK_PORT, send_array, sizeof(send_array), peerIp));
+    TEST_ASSERT_EQUAL_INT(2, sent_nb);
+}
+
+void test_network_rx_callback(void) {
+    uint8_t peerIp[4] = {192, 168, 2, 16};
+    uint8_t peerMac[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    uint8_t received_array[64];
+    uint16_t received_size;
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlGetData_StubWithCallback(get_data_Callback);
+    MacCtrlSendData_StubWithCallback(record_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    sent_nb = 0;
+    rx_cb_nb = 0;
+
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkCallbackPortDesc));
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, peerIp, peerMac, false));
+    memcpy(in_buffer, udp_com_rx_barray, sizeof(udp_com_rx_barray));
+    in_buff_size = sizeof(udp_com_rx_barray);
+    // Message taken by the callback is not stored
+    rx_cb_consume = true;
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_EQUAL_INT(1, rx_cb_nb);
+    TEST_ASSERT_EQUAL_INT(14, rx_cb_size);
+    TEST_ASSERT_EQUAL_MEMORY("Hessian matrix", rx_cb_data, 14);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(peerIp, rx_cb_src.IpAddr, 4);
+    TEST_ASSERT_EQUAL_INT(25565, rx_cb_src.PortNb);
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+    // Answer sent in the callback waits for the tx pass
+    TEST_ASSERT_EQUAL_INT(0, sent_nb);
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    TEST_ASSERT_EQUAL_MEMORY("Hessian matrix", out_buffer + NETWORK_HEADER_SIZE, 14);
+    // Message left by the callback is stored
+    rx_cb_consume = false;
+    hasData = true;
+    NetworkCtrlRxProcess(MAIN_NETWORK_CTRL);
+    hasData = false;
+    TEST_ASSERT_EQUAL_INT(2, rx_cb_nb);
+    TEST_ASSERT_TRUE(NetworkPortReadBuff(SEC_NETWORK_PORT, received_array, &received_size, sizeof(received_array), NULL));
+    TEST_ASSERT_EQUAL_INT(14, received_size);
+    TEST_ASSERT_EQUAL_MEMORY("Hessian matrix", received_array, 14);
+}
+
+void test_network_rx_callback_close(void) {
+    uint8_t ipAdr[4] = {192, 168, 2, 0};
+    uint8_t macAdr[6] = {0x11, 0x22, 0x44, 0x55, 0x88, 0xaa};
+    uint8_t send_array[] = {0, 1, 2, 3, 4};
+
+    // Mac_ctrl spoofing
+    MacCtrlHasData_StubWithCallback(has_data_Callback);
+    MacCtrlGetData_StubWithCallback(get_data_Callback);
+    MacCtrlSendData_StubWithCallback(record_send_Callback);
+    // Timer spoofing
+    TimerRefGetTime_StubWithCallback(time_get_Callback);
+    TimerRefIsPassed_StubWithCallback(time_passed_Callback);
+    // Init globals
+    hasData = false;
+    timeVal = 0;
+    sent_nb = 0;
+    rx_cb_nb = 0;
+
+    // Checksummed datagram holding two messages
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkClosingPortDesc));
+    TEST_ASSERT_TRUE(NetworkCtrlAddArpEntry(MAIN_NETWORK_CTRL, ipAdr, macAdr, false));
+    TEST_ASSERT_TRUE(NetworkPortSendByte(SEC_NETWORK_PORT, 0x55, NULL));
+    TEST_ASSERT_TRUE(NetworkPortSendBuff(SEC_NETWORK_PORT, send_array, sizeof(send_array), NULL));
+    NetworkCtrlTxProcess(MAIN_NETWORK_CTRL);
+    TEST_ASSERT_EQUAL_INT(1, sent_nb);
+    TEST_ASSERT_NOT_EQUAL(0, (out_buffer[40] << 8) | out_buffer[41]);
+    // Port closed by the callback of the first message gets no other one
+    loop_frame_back(out_buffer, out_buff_size);
+    TEST_ASSERT_EQUAL_INT(1, rx_cb_nb);
+    TEST_ASSERT_FALSE(NetworkPortClose(SEC_NETWORK_PORT));
+    // Reopened port does not get the dropped messages
+    TEST_ASSERT_TRUE(NetworkPortAdd(SEC_NETWORK_PORT, &NetworkReasmPortDesc));
+    TEST_ASSERT_TRUE(NetworkPortIsRxEmpty(SEC_NETWORK_PORT));
+}
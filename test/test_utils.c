@@ -0,0 +1,77 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "unity.h"
+#include "Utils.h"
+
+#define TEST_BUFFER_SIZE 9001
+
+static uint8_t _buffer[TEST_BUFFER_SIZE + 1];
+static bool init_srand;
+
+
+static uint16_t reference_checksum(const uint8_t *pData, uint32_t size) {
+    uint32_t sum = 0;
+
+    for (uint32_t idx = 0; idx < size; idx++) {
+        sum += (idx % 2 == 0) ? ((uint32_t)pData[idx] << 8) : pData[idx];
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return (uint16_t)~sum;
+}
+
+void setUp(void) {
+    // Init rand
+    if (!init_srand) {
+        srand(0x42424242);
+        init_srand = true;
+    }
+    for (uint32_t idx = 0; idx < sizeof(_buffer); idx++) {
+        _buffer[idx] = (uint8_t)rand();
+    }
+}
+
+void tearDown(void) {
+}
+
+void test_utils_inet_checksum(void) {
+    // RFC 1071 example
+    const uint8_t rfc_array[] = {0x00, 0x01, 0xf2, 0x03, 0xf4, 0xf5, 0xf6, 0xf7};
+    const uint32_t sizes[] = {0, 1, 2, 3, 20, 21, 63, 64, 65, 1472, 1500, 8999, 9000};
+
+    TEST_ASSERT_EQUAL_HEX16(0x220d, UtilsInetChecksum(rfc_array, sizeof(rfc_array)));
+    // Sizes and misaligned data, compared with a byte by byte sum
+    for (uint8_t idx = 0; idx < sizeof(sizes) / sizeof(sizes[0]); idx++) {
+        TEST_ASSERT_EQUAL_HEX16(reference_checksum(_buffer, sizes[idx]), UtilsInetChecksum(_buffer, sizes[idx]));
+        TEST_ASSERT_EQUAL_HEX16(reference_checksum(_buffer + 1, sizes[idx]), UtilsInetChecksum(_buffer + 1, sizes[idx]));
+    }
+    // Carries of long all-ones data are folded
+    memset(_buffer, 0xFF, TEST_BUFFER_SIZE);
+    TEST_ASSERT_EQUAL_HEX16(0x0000, UtilsInetChecksum(_buffer, 9000));
+    TEST_ASSERT_EQUAL_HEX16(0x00FF, UtilsInetChecksum(_buffer, 9001));
+    // Chained sums
+    TEST_ASSERT_EQUAL_HEX16(reference_checksum(_buffer, 100), (uint16_t)~UtilsInetSum(_buffer + 40, 60, UtilsInetSum(_buffer, 40, 0)));
+}
+
+void test_utils_inet_checksum_update(void) {
+    uint8_t header[20];
+    uint16_t checksum;
+
+    memcpy(header, _buffer, sizeof(header));
+    header[10] = 0;
+    header[11] = 0;
+    checksum = UtilsInetChecksum(header, sizeof(header));
+    header[10] = (uint8_t)(checksum >> 8);
+    header[11] = (uint8_t)(checksum & 0xFF);
+    TEST_ASSERT_EQUAL_HEX16(0, UtilsInetChecksum(header, sizeof(header)));
+    // Modify a word and update the checksum incrementally
+    for (uint16_t newWord = 0; newWord < 0x400; newWord += 0x55) {
+        uint16_t oldWord = (uint16_t)((header[2] << 8) | header[3]);
+        checksum = UtilsInetChecksumUpdate(checksum, oldWord, newWord);
+        header[2] = (uint8_t)(newWord >> 8);
+        header[3] = (uint8_t)(newWord & 0xFF);
+        header[10] = (uint8_t)(checksum >> 8);
+        header[11] = (uint8_t)(checksum & 0xFF);
+        TEST_ASSERT_EQUAL_HEX16(0, UtilsInetChecksum(header, sizeof(header)));
+    }
+}